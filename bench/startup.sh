@@ -0,0 +1,64 @@
+#!/bin/sh
+# 单文件模式(编辑器保存时调用)的启动耗时基准
+# 用法：bench/startup.sh <mdtool2 可执行文件> [次数，默认 200] [上限毫秒，默认 5]
+# 对约 2 KB 的文档重复执行 mdtool -p doc.md -e cb.li add -i cpp，分别测量文档无需修改
+# 与每次都需要写回两种情况下每次调用的平均耗时，任一超过上限时返回 1
+
+bin=$1
+runs=${2:-200}
+limit=${3:-5}
+if [ ! -x "$bin" ]; then
+    echo "用法：$0 <mdtool2 可执行文件> [次数] [上限毫秒]" >&2
+    exit 2
+fi
+
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+doc="$dir/doc.md"
+
+# 约 2 KB 的纯 ASCII 文档，代码块都没有语言
+orig="# Startup benchmark
+"
+i=0
+while [ $i -lt 18 ]; do
+    orig="$orig
+Paragraph $i with some text to make the document look like a real note.
+
+\`\`\`
+int value_$i = $i;
+return value_$i;
+\`\`\`
+"
+    i=$((i + 1))
+done
+
+now() {
+    date +%s%N
+}
+
+# 运行 runs 次，输出平均每次的毫秒数；reset 为 1 时每次运行前恢复原文档
+measure() {
+    reset=$1
+    printf '%s' "$orig" > "$doc"
+    "$bin" -p "$doc" -e cb.li add -i cpp > /dev/null || exit 1
+    n=0
+    start=$(now)
+    while [ $n -lt "$runs" ]; do
+        if [ "$reset" = 1 ]; then
+            printf '%s' "$orig" > "$doc"
+        fi
+        "$bin" -p "$doc" -e cb.li add -i cpp > /dev/null
+        n=$((n + 1))
+    done
+    end=$(now)
+    awk -v ns=$((end - start)) -v runs="$runs" 'BEGIN { printf "%.3f", ns / runs / 1000000 }'
+}
+
+unchanged=$(measure 0)
+modified=$(measure 1)
+echo "文档大小 $(wc -c < "$doc") 字节，每种情况 $runs 次"
+echo "无需修改：$unchanged ms/次"
+echo "需要写回：$modified ms/次"
+echo "上限：$limit ms/次"
+
+awk -v a="$unchanged" -v b="$modified" -v limit="$limit" 'BEGIN { exit !(a <= limit && b <= limit) }'
@@ -3,6 +3,7 @@
 //
 
 #include "cli.h"
+#include "tools/tools.h"
 
 
 cxxopts::Options cmd_opts("mdtool", "Markdown代码块处理工具");
@@ -57,9 +58,14 @@ CommandReturn commandParsing(const int argc, char* argv[]) {
 统一的操作输入选项
     使用方式：
       操作对象 操作内容 附加参数 （cb.lf add）
-      快捷操作 （addl）
+      快捷操作 （addl，delc）
     操作详情：
       cb （代码块）包含li，ct           {add，upd，rmv，format(去除多余换行，空白字符);add,rmv,format}
+      cb export <目录>                 导出所有代码块：内容按哈希去重存放，并生成 manifest.ndjson 清单
+      tb （表格）                      {format(按显示宽度对齐各列)}
+      en （编码）                      {utf8 [bom] [crlf] [force](转换为utf8，确认可无损还原后写入)}
+      fm （front matter）              {get <键>，set <键> <值>，del <键>(只读取文档开头，正文原样保留)}
+      fm get                           值输出到标准输出：单个文档只输出值，文件夹每行为 路径<Tab>值(可用 -l 1 隐藏其他日志)
       mh （多级标题）                  {add1,sub1,add2,sub2,add3,sub3,}
       il （内部链接）                  {}
       el （外部链接）
@@ -79,9 +85,23 @@ CommandReturn commandParsing(const int argc, char* argv[]) {
         cxxopts::value<int>(options.start))
     ("l,log","设置日志输出级别，默认3",
         cxxopts::value<int>(options.log))
+    ("t,timeout","文件夹扫描超时时间(秒)，小于等于0不限制，默认1.5",
+        cxxopts::value<double>(options.kDefaultPathScanTimeout))
+    ("j,jobs","处理文件夹时使用的线程数，默认按CPU核数",
+        cxxopts::value<int>(options.jobs))
+    ("changed-since","只处理git仓库中相对指定提交发生变化的md文档",
+        cxxopts::value<std::string>(options.changedSince))
+    ("staged","只处理git仓库中已暂存的md文档",
+        cxxopts::value<bool>(options.staged)->implicit_value("true")->default_value("false"))
+    ("io","处理文件夹时的读写后端：auto、uring、thread，默认auto",
+        cxxopts::value<std::string>(options.io)->default_value("auto"))
     ("b,backup","指定是否使用备份",
-        cxxopts::value<std::optional<bool>>(options.bakup)->implicit_value("true")->default_value("false"))  ;
+        cxxopts::value<std::optional<bool>>(options.bakup)->implicit_value("true")->default_value("false"))
+    ("w,watch","常驻监听文档或文件夹，保存后立即执行操作",
+        cxxopts::value<bool>(options.watch)->implicit_value("true")->default_value("false"))  ;
 
+    // -e cb.li add 中操作对象之后的单词也归入 -e
+    cmd_opts.parse_positional({"execute"});
 
 
 
@@ -101,9 +121,54 @@ CommandReturn commandParsing(const int argc, char* argv[]) {
 
 
         // 其他解析
+        useLog = static_cast<LOG_TYPE>(options.log);
+        options.useLog = useLog;
+        options.path = fs::path(reinterpret_cast<const char8_t*>(options.path_str.c_str()));
+
+        // 旧版操作选项转换为统一操作
+        if (oldOptions.addl) {
+            eOptions = {"cb.li", "add"};
+        }
+        if (oldOptions.delcl) {
+            eOptions = {"cb.ct", "del"};
+        }
+        if (oldOptions.updl || oldOptions.rmvl) {
+            options.logs = {logs::alog(LOG_TYPE::Error, "该旧版操作暂未实现")};
+            cmd_ret.options = options;
+            cmd_ret.funcPtr = none;
+            return cmd_ret;
+        }
+        if (options.io != "auto" && options.io != "uring" && options.io != "thread") {
+            options.logs = {logs::alog(LOG_TYPE::Error, "未知的读写后端：" + options.io)};
+            cmd_ret.options = options;
+            cmd_ret.funcPtr = none;
+            return cmd_ret;
+        }
+        if (options.staged && !options.changedSince.empty()) {
+            options.logs = {logs::alog(LOG_TYPE::Error, "--staged 与 --changed-since 不能同时使用")};
+            cmd_ret.options = options;
+            cmd_ret.funcPtr = none;
+            return cmd_ret;
+        }
+        if (eOptions.empty()) {
+            cmd_ret.funcPtr = help;
+            cmd_ret.success = true;
+            return cmd_ret;
+        }
+
+        for (const auto& word : eOptions) {
+            if (!options.option.empty()) {
+                options.option += ' ';
+            }
+            options.option += word;
+        }
+        cmd_ret.options = options;
+        cmd_ret.funcPtr = options.watch ? tools::watch : tools::execute;
+        cmd_ret.success = true;
 
     } catch (const std::exception& e) {
         options.logs = {logs::alog(LOG_TYPE::Error, e.what())};
+        cmd_ret.options = options;
         cmd_ret.funcPtr = none;
         cmd_ret.success = false;
         return cmd_ret;
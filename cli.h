@@ -24,6 +24,9 @@ struct oldOptions {
     bool delcl;
 };
 
+// 解析命令行，得到处理函数及其参数
+CommandReturn commandParsing(int argc, char* argv[]);
+
 
 
 
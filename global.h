@@ -62,7 +62,7 @@ namespace logs {
     }
 
     inline void printLog(const alog& log, const LOG_TYPE useLog) {
-        if (const auto& [type, msg] = log; static_cast<int>(useLog) <= static_cast<int>(type)) {
+        if (const auto& [type, msg] = log; static_cast<int>(type) <= static_cast<int>(useLog)) {
             printLog(log);
         }
     }
@@ -125,7 +125,7 @@ namespace logs {
         // tips在Warn日志后打印,如: [WARN] 当前文件过大！\n是否继续操作？(Y/n):
 
         // 检查是否需要打印该日志
-        if (static_cast<int>(useLog) > static_cast<int>(type)) {
+        if (static_cast<int>(type) > static_cast<int>(useLog)) {
             return true;  // 日志级别不够,不打印但返回true继续执行
         }
 
@@ -174,18 +174,26 @@ struct InputOptions {
     std::string input_file;
     std::string path_str;     // 单个md文档路径,或包含md文档的文件夹路径
     std::string option;
-    int start;        // 指定md文档中操作的起始位置
+    int start = 0;            // 指定md文档中操作的起始位置
     int number = 0;           // 指定在对象中操作的位置或数量
     int log = 3;
+    int jobs = 0;             // 处理文件夹时的线程数，0 表示按 CPU 核数
     LOG_TYPE useLog = LOG_TYPE::Info;
     std::optional<bool> bakup = std::nullopt;
-    double kDefaultPathScanTimeout = 1.5;
+    bool watch = false;       // 常驻监听文件夹，文件保存后立即处理
+    std::string io = "auto";  // 文件夹模式的读写后端：auto、uring、thread
+    std::string changedSince; // 只处理相对该提交发生变化的文档
+    bool staged = false;      // 只处理已暂存的文档
+    double kDefaultPathScanTimeout = 1.5; // 文件夹扫描超时时间(秒)，<= 0 不限制
+    uintmax_t kStreamThreshold = 64 << 20;  // 超过该大小的文档使用流式处理
     std::vector<logs::alog> logs; // 命令行解析日志暂存
 };
 
 struct FinalFuncReturn {
     bool success = false;
+    bool modified = false;    // 文档内容是否发生修改
     std::vector<logs::alog> logs;
+    std::optional<std::string> output;  // 查询操作的结果(如 fm get 的值)，由调用方原样写到标准输出
 };
 
 using FinalFunc = FinalFuncReturn(*)(const InputOptions&);
@@ -7,9 +7,17 @@ int main(const int argc, char* argv[]) {
     SetConsoleCP(CP_UTF8);
 #endif
 
+    const auto [options, funcPtr, success] = commandParsing(argc, argv);
+    if (!funcPtr) {
+        logs::printLogs(options.logs, useLog);
+        return ret(1);
+    }
 
+    const auto r = funcPtr(options);
+    if (r.output) {
+        std::cout << *r.output << std::endl;
+    }
+    logs::printLogs(r.logs, useLog);
 
-
-
-    return ret(0);
+    return ret(r.success ? 0 : 1);
 }
\ No newline at end of file
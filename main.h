@@ -7,6 +7,8 @@
 
 #include <iostream>
 
+#include "cli.h"
+
 #ifdef _WIN32
 #include <windows.h>
 #endif
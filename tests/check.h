@@ -0,0 +1,49 @@
+//
+// Created by zerox on 2025/11/22.
+//
+
+#ifndef MDTOOL2_CHECK_H
+#define MDTOOL2_CHECK_H
+
+#include <algorithm>
+#include <iostream>
+#include <string_view>
+
+
+// 测试用的最小断言：失败时打印位置并计数，main 返回 check::result()
+namespace check {
+    inline int failures = 0;
+
+    inline void fail(const char* file, const int line, const std::string_view what) {
+        ++failures;
+        std::cerr << file << ":" << line << ": 失败：" << what << "\n";
+    }
+
+    // 比较两段文本，不同时打印第一个不同的位置及其前后内容
+    inline void sameText(const char* file, const int line, const std::string_view actual,
+                         const std::string_view expected, const std::string_view what) {
+        if (actual == expected) {
+            return;
+        }
+        const auto [a, e] = std::mismatch(actual.begin(), actual.end(), expected.begin(), expected.end());
+        const size_t at = static_cast<size_t>(a - actual.begin());
+        const size_t from = at > 40 ? at - 40 : 0;
+        fail(file, line, what);
+        std::cerr << "  长度 " << actual.size() << " / 期望 " << expected.size() << "，第一个不同位于 " << at << "\n"
+                  << "  实际：" << actual.substr(from, 80) << "\n"
+                  << "  期望：" << expected.substr(from, 80) << "\n";
+    }
+
+    inline int result() {
+        if (failures > 0) {
+            std::cerr << failures << " 项检查失败\n";
+        }
+        return failures > 0 ? 1 : 0;
+    }
+}
+
+#define CHECK(cond) ((cond) ? void() : check::fail(__FILE__, __LINE__, #cond))
+#define CHECK_TEXT(actual, expected) check::sameText(__FILE__, __LINE__, (actual), (expected), #actual " == " #expected)
+
+
+#endif //MDTOOL2_CHECK_H
@@ -0,0 +1,73 @@
+//
+// Created by zerox on 2025/11/22.
+//
+
+// cb export：多个线程同时导出相同的代码块，内容文件只按哈希存一份、内容完整，不留下临时文件
+
+#include <thread>
+#include <unistd.h>
+
+#include "check.h"
+#include "tools/tool_core/CodeExport.h"
+
+
+namespace {
+    std::string readAll(const fs::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+}
+
+
+int main() {
+    const fs::path dir = fs::temp_directory_path() / ("mdtool_test_codeexport_" + std::to_string(::getpid()));
+
+    // 每个文档都包含同样的 64 个代码块，较大的代码块使写入与其他线程的检查有机会交错
+    std::string doc;
+    std::vector<std::string> bodies;
+    for (int i = 0; i < 64; ++i) {
+        bodies.push_back(std::string(i * 997 % 50000 + 1, static_cast<char>('a' + i % 26)) + "\n");
+        doc += "```cpp\n" + bodies.back() + "```\n\n";
+    }
+
+    constexpr int kThreads = 8;
+    constexpr int kDocs = 16;
+    std::vector<std::thread> threads;
+    std::atomic<int> failed = 0;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int d = t; d < kDocs; d += kThreads) {
+                const auto rt = CodeExport::session(dir).add("doc" + std::to_string(d) + ".md", doc);
+                failed += rt.success ? 0 : 1;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(failed == 0);
+    CHECK(CodeExport::finishSession(dir, false).success);
+
+    // 每个内容文件与代码块完全一致，清单中每个文档 64 条记录
+    for (const auto& body : bodies) {
+        const std::string hash = tool::sha256(body);
+        CHECK_TEXT(readAll(dir / hash.substr(0, 2) / hash.substr(2)), body);
+    }
+    size_t lines = 0;
+    for (const char c : readAll(dir / "manifest.ndjson")) {
+        lines += c == '\n';
+    }
+    CHECK(lines == kDocs * bodies.size());
+
+    size_t blobs = 0;
+    for (const auto& entry : fs::recursive_directory_iterator(dir)) {
+        const std::string name = entry.path().filename().string();
+        CHECK(name.find(".tmp") == std::string::npos);
+        blobs += entry.is_regular_file() && name != "manifest.ndjson";
+    }
+    CHECK(blobs == bodies.size());
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    return check::result();
+}
@@ -0,0 +1,81 @@
+//
+// Created by zerox on 2025/11/22.
+//
+
+// 忽略规则：walk、isIgnored 与从子文件夹开始的 walk(base, root) 判断一致
+
+#include <fstream>
+#include <set>
+#include <unistd.h>
+
+#include "check.h"
+#include "tools/tool_core/DirWalker.h"
+
+
+namespace {
+    void writeFile(const fs::path& path, const std::string_view data = "# doc\n") {
+        fs::create_directories(path.parent_path());
+        std::ofstream(path, std::ios::binary) << data;
+    }
+
+    std::set<std::string> walked(const fs::path& base, const fs::path& root, std::set<std::string>* dirs = nullptr) {
+        std::set<std::string> files;
+        DirWalker(0).walk(base, root, [&](const fs::path& file) {
+            files.insert(file.lexically_relative(base).generic_string());
+            return true;
+        }, [&](const fs::path& dir) {
+            if (dirs) {
+                dirs->insert(dir.lexically_relative(base).generic_string());
+            }
+            return true;
+        });
+        return files;
+    }
+}
+
+
+int main() {
+    const fs::path root = fs::temp_directory_path() / ("mdtool_test_dirwalker_" + std::to_string(::getpid()));
+    fs::remove_all(root);
+    writeFile(root / ".gitignore", "build/\n*.tmp.md\n!keep.tmp.md\n");
+    writeFile(root / "docs/.mdtoolignore", "drafts\n/local.md\n");
+    for (const char* name : {"a.md", "notes.txt", "x.tmp.md", "keep.tmp.md", "build/x.md", "node_modules/n.md",
+                             ".git/g.md", "docs/b.md", "docs/local.md", "docs/drafts/d.md", "docs/sub/local.md",
+                             "docs/sub/build/y.md", "docs/sub/c.MARKDOWN"}) {
+        writeFile(root / name);
+    }
+
+    const std::set<std::string> expected{"a.md", "keep.tmp.md", "docs/b.md", "docs/sub/local.md",
+                                         "docs/sub/c.MARKDOWN"};
+    CHECK(walked(root, root) == expected);
+
+    // isIgnored 对每个文档的判断与 walk 一致
+    for (const auto& entry : fs::recursive_directory_iterator(root)) {
+        if (!entry.is_regular_file() || !DirWalker::isMarkdown(entry.path())) {
+            continue;
+        }
+        const std::string rel = entry.path().lexically_relative(root).generic_string();
+        if (DirWalker::isIgnored(root, entry.path()) == expected.contains(rel)) {
+            check::fail(__FILE__, __LINE__, "isIgnored 与 walk 不一致：" + rel);
+        }
+    }
+    CHECK(DirWalker::isIgnored(root, root / "build", true));
+    CHECK(DirWalker::isIgnored(root, root / "node_modules", true));
+    CHECK(DirWalker::isIgnored(root, root / "docs/drafts", true));
+    CHECK(!DirWalker::isIgnored(root, root / "docs", true));
+    CHECK(!DirWalker::isIgnored(root, root / "docs/sub", true));
+
+    // 从子文件夹开始扫描时，上层的忽略文件同样生效
+    std::set<std::string> dirs;
+    CHECK(walked(root, root / "docs", &dirs) == (std::set<std::string>{"docs/b.md", "docs/sub/local.md",
+                                                                       "docs/sub/c.MARKDOWN"}));
+    CHECK(dirs == (std::set<std::string>{"docs", "docs/sub"}));
+    dirs.clear();
+    CHECK(walked(root, root / "build", &dirs).empty());
+    CHECK(dirs.empty());
+    CHECK(walked(root, root / "docs/sub/build").empty());
+
+    std::error_code ec;
+    fs::remove_all(root, ec);
+    return check::result();
+}
@@ -0,0 +1,144 @@
+//
+// Created by zerox on 2025/11/22.
+//
+
+// fm：定位 front matter、设置的值按需加引号且能原样读回、写回文件、get 的输出格式
+
+#include <unistd.h>
+
+#include "check.h"
+#include "tools/tools.h"
+#include "tools/tool_core/FrontMatter.h"
+
+
+namespace {
+    // 设置后重新查找，返回写出的那一行(去除换行)与读回的值
+    std::pair<std::string, std::string> roundTrip(const std::string_view header, const std::string_view value) {
+        const std::string updated = FrontMatter::set(header, "k", value);
+        const auto field = FrontMatter::find(updated, "k");
+        if (!field) {
+            return {};
+        }
+        std::string line = updated.substr(field->begin, field->end - field->begin);
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+            line.pop_back();
+        }
+        return {line, field->text()};
+    }
+
+    std::string readAll(const fs::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    void writeAll(const fs::path& path, const std::string_view data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    InputOptions optionsFor(const fs::path& path, const std::string& option) {
+        InputOptions options;
+        options.path = path;
+        options.option = option;
+        options.jobs = 2;
+        options.io = "thread";
+        return options;
+    }
+}
+
+
+int main() {
+    // 结束行可以是 --- 或 ...，没有结束行或开头不是 --- 时没有 front matter
+    CHECK(FrontMatter::locate("---\na: 1\n---\nbody", true) == 13);
+    CHECK(FrontMatter::locate("\xEF\xBB\xBF---\na: 1\n...\n", true) == 16);
+    CHECK(FrontMatter::locate("---\na: 1\n", true) == 0);
+    CHECK(FrontMatter::locate("---\na: 1\n", false) == std::string_view::npos);
+    CHECK(FrontMatter::locate("# title\n---\n", true) == 0);
+
+    // 需要引号的值写出后按原样读回，普通值、数字、布尔值与流式集合不加引号
+    const std::string header = "---\ntitle: x\n---\n";
+    const std::pair<std::string_view, std::string_view> cases[] = {
+        {"plain text", "k: plain text"},
+        {"42", "k: 42"},
+        {"true", "k: true"},
+        {"-1", "k: -1"},
+        {"[a, b]", "k: [a, b]"},
+        {"{a: 1}", "k: {a: 1}"},
+        {"http://x.y/z", "k: http://x.y/z"},
+        {"a: b", "k: 'a: b'"},
+        {"#x", "k: '#x'"},
+        {"a #x", "k: 'a #x'"},
+        {"[x", "k: '[x'"},
+        {"[a] b [c]", "k: '[a] b [c]'"},
+        {"- item", "k: '- item'"},
+        {"end:", "k: 'end:'"},
+        {"it's", "k: it's"},
+        {"'quoted'", "k: '''quoted'''"},
+        {"\"dq\"", "k: '\"dq\"'"},
+        {" lead", "k: ' lead'"},
+        {"*ref", "k: '*ref'"},
+        {"", "k: ''"},
+        {"line1\nline2", "k: \"line1\\nline2\""},
+        {"a\\b\n\"c\"\t\x01", "k: \"a\\\\b\\n\\\"c\\\"\\t\\x01\""},
+        {"中文: 值", "k: '中文: 值'"},
+    };
+    for (const auto& [value, line] : cases) {
+        const auto [written, read] = roundTrip(header, value);
+        CHECK_TEXT(written, line);
+        CHECK_TEXT(read, value);
+    }
+
+    // 已有键原位替换，新键加在结束行之前，换行符与原 header 一致，删除时连同块状值一起删除
+    CHECK_TEXT(FrontMatter::set("---\r\na: 1\r\nb: 2\r\n---\r\n", "a", "x: y"), "---\r\na: 'x: y'\r\nb: 2\r\n---\r\n");
+    CHECK_TEXT(FrontMatter::set("---\na: 1\n---\n", "c", "3"), "---\na: 1\nc: 3\n---\n");
+    CHECK_TEXT(FrontMatter::set("", "a", "1"), "---\na: 1\n---\n");
+    CHECK_TEXT(FrontMatter::remove("---\na:\n  - x\n  - y\nb: 2\n---\n", "a"), "---\nb: 2\n---\n");
+
+    // 读取时去除行尾注释，引号内的 # 不是注释；块状值原样返回
+    const std::string existing = "---\na: 'x # y' # note\nb: v # note\nc: # empty\nd: \"\\u4e2d\\x41\"\n"
+                                 "e: |\n  one\n  two\n---\n";
+    CHECK_TEXT(FrontMatter::find(existing, "a")->text(), "x # y");
+    CHECK_TEXT(FrontMatter::find(existing, "b")->text(), "v");
+    CHECK_TEXT(FrontMatter::find(existing, "c")->text(), "");
+    CHECK_TEXT(FrontMatter::find(existing, "d")->text(), "中A");
+    CHECK_TEXT(FrontMatter::find(existing, "e")->text(), "  one\n  two");
+
+    const fs::path dir = fs::temp_directory_path() / ("mdtool_test_frontmatter_" + std::to_string(::getpid()));
+    fs::create_directories(dir / "sub");
+    const fs::path a = dir / "a.md";
+    const fs::path b = dir / "sub" / "b.md";
+    const fs::path c = dir / "c.md";
+    std::string body(100000, 'x');
+    body += "\n";
+
+    // 长度不变时原地覆盖，长度变化时经临时文件替换，正文均原样保留
+    writeAll(a, "---\ndraft: true\n---\n" + body);
+    std::string error;
+    auto head = FrontMatter::read(a, error);
+    CHECK(head && !head->eof);
+    CHECK(FrontMatter::splice(a, *head, "---\ndraft: null\n---\n", error));
+    CHECK_TEXT(readAll(a), "---\ndraft: null\n---\n" + body);
+    head = FrontMatter::read(a, error);
+    CHECK(head && FrontMatter::splice(a, *head, "---\ndraft: false\ntitle: '#1'\n---\n", error));
+    CHECK_TEXT(readAll(a), "---\ndraft: false\ntitle: '#1'\n---\n" + body);
+    CHECK(!fs::exists(dir / "a.md.mdtool.tmp"));
+
+    // 单个文档只输出值；没有这个键时不输出
+    auto set = optionsFor(a, "fm set title a: b");
+    CHECK(tools::execute(set).modified);
+    const auto one = tools::execute(optionsFor(a, "fm get title"));
+    CHECK(one.success && one.output);
+    CHECK_TEXT(one.output.value_or(""), "a: b");
+    CHECK(!tools::execute(optionsFor(a, "fm get missing")).output);
+
+    // 文件夹按相对路径排序，每行为 路径<Tab>值，值中的换行与制表符转义
+    writeAll(b, "---\ntitle: \"two\\nlines\\tand tab\"\n---\n");
+    writeAll(c, "# no front matter\n");
+    const auto all = tools::execute(optionsFor(dir, "fm get title"));
+    CHECK(all.success && all.output);
+    CHECK_TEXT(all.output.value_or(""), "a.md\ta: b\nsub/b.md\ttwo\\nlines\\tand tab");
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    return check::result();
+}
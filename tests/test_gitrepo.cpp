@@ -0,0 +1,133 @@
+//
+// Created by zerox on 2025/11/22.
+//
+
+// --changed-since / --staged：读取 index(v2 与 v4)、pack 中的 delta 对象，损坏的 index 报错而不越界；以及 sha256
+
+#include <unistd.h>
+
+#include "check.h"
+#include "tools/tool_core/GitRepo.h"
+
+
+namespace {
+    fs::path repoDir;
+
+    bool git(const std::string& args) {
+        const std::string cmd = "git -C '" + repoDir.string() + "' -c user.name=test -c user.email=test@test "
+                                "-c core.autocrlf=false -c gc.auto=0 " + args + " >/dev/null 2>&1";
+        return std::system(cmd.c_str()) == 0;
+    }
+
+    void writeAll(const fs::path& path, const std::string_view data) {
+        fs::create_directories(path.parent_path());
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    std::string changed(const std::string& rev, const bool withWorktree) {
+        const auto repo = GitRepo::discover(repoDir);
+        if (!repo) {
+            return "<no repo>";
+        }
+        const auto rt = repo->changed(rev, withWorktree);
+        if (!rt.success) {
+            return "<error>";
+        }
+        std::string joined;
+        for (const auto& path : rt.paths) {
+            joined += (joined.empty() ? "" : " ") + path;
+        }
+        return joined;
+    }
+
+    void appendBe32(std::string& out, const uint32_t v) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            out += static_cast<char>(v >> shift & 0xFF);
+        }
+    }
+}
+
+
+int main() {
+    CHECK_TEXT(tool::sha256(""), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    CHECK_TEXT(tool::sha256("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    // 跨越一个 64 字节分块边界，覆盖长度填充到下一块的情况
+    CHECK_TEXT(tool::sha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+               "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+    if (std::system("git --version >/dev/null 2>&1") != 0) {
+        std::cerr << "未找到 git，跳过仓库相关检查\n";
+        return check::result();
+    }
+
+    repoDir = fs::temp_directory_path() / ("mdtool_test_gitrepo_" + std::to_string(::getpid()));
+    fs::create_directories(repoDir);
+    CHECK(git("init -q"));
+
+    // 目录中文件较多，两次提交的树对象相近，gc 后以 delta 形式存放在 pack 中
+    std::string body;
+    for (int i = 0; i < 200; ++i) {
+        body += "line " + std::to_string(i) + "\n";
+    }
+    for (int i = 0; i < 300; ++i) {
+        writeAll(repoDir / "docs" / ("f" + std::to_string(i) + ".md"), body + std::to_string(i) + "\n");
+    }
+    writeAll(repoDir / "a.md", "# a\n");
+    writeAll(repoDir / "note.txt", "not markdown\n");
+    CHECK(git("add -A") && git("commit -q -m one"));
+    writeAll(repoDir / "docs" / "f7.md", body + "changed\n");
+    writeAll(repoDir / "docs" / "new.md", "# new\n");
+    writeAll(repoDir / "note.txt", "still not markdown\n");
+    CHECK(git("add -A") && git("commit -q -m two"));
+    CHECK(git("gc -q --aggressive"));
+    size_t loose = 0;
+    for (const auto& entry : fs::directory_iterator(repoDir / ".git" / "objects")) {
+        loose += entry.path().filename().string().size() == 2;
+    }
+    CHECK(loose == 0);
+
+    // 提交之间的差异全部从 pack 中读取
+    CHECK_TEXT(changed("HEAD~1", false), "docs/f7.md docs/new.md");
+    CHECK_TEXT(changed("HEAD", false), "");
+
+    // 已暂存的新文档与工作区中修改的文档
+    writeAll(repoDir / "a.md", "# a\nmore\n");
+    writeAll(repoDir / "b.md", "# b\n");
+    CHECK(git("add b.md"));
+    for (const int version : {2, 4}) {
+        CHECK(git("update-index --index-version " + std::to_string(version)));
+        CHECK_TEXT(changed("HEAD", false), "b.md");
+        CHECK_TEXT(changed("HEAD", true), "a.md b.md");
+        CHECK_TEXT(changed("HEAD~1", false), "b.md docs/f7.md docs/new.md");
+    }
+
+    // 损坏的 v4 index：路径前缀的变长整数一直延续到文件末尾，必须报错而不能读越界
+    const fs::path index = repoDir / ".git" / "index";
+    std::string corrupt = "DIRC";
+    appendBe32(corrupt, 4);
+    appendBe32(corrupt, 1);
+    corrupt.append(62, '\0');
+    corrupt.append(16 + 20, '\x80');
+    writeAll(index, corrupt);
+    CHECK_TEXT(changed("HEAD", false), "<error>");
+
+    // 前缀长度超过上一条路径(此处为第一条，上一条为空)
+    corrupt.resize(12 + 62);
+    corrupt += "\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x7F" "x.md";
+    corrupt.append(1, '\0');
+    corrupt.append(20, '\0');
+    writeAll(index, corrupt);
+    CHECK_TEXT(changed("HEAD", false), "<error>");
+
+    // 条目数多于实际内容
+    corrupt.resize(12);
+    corrupt.append(20, '\0');
+    corrupt[11] = 5;
+    writeAll(index, corrupt);
+    CHECK_TEXT(changed("HEAD", false), "<error>");
+
+    std::error_code ec;
+    fs::remove_all(repoDir, ec);
+    return check::result();
+}
@@ -0,0 +1,120 @@
+//
+// Created by zerox on 2025/11/22.
+//
+
+// 批量读写后端：io_uring 与线程池读到、写出的内容都与同步读写相同
+// 同一文件另外以 MDTOOL_URING_FAIL_AT 编译为 test_iobackend_fault，覆盖提交失败后的回退与重试
+
+#include <random>
+#include <set>
+#include <thread>
+#include <unistd.h>
+
+#include "check.h"
+#include "tools/tool_core/IoBackend.h"
+
+
+namespace {
+    constexpr uintmax_t kMaxSize = 256 << 10;
+
+    std::string contentOf(const size_t i, const size_t size) {
+        std::string data(size, '\0');
+        std::mt19937 rng(static_cast<unsigned>(i));
+        for (char& c : data) {
+            c = static_cast<char>('a' + rng() % 26);
+        }
+        return data;
+    }
+
+    std::string readAll(const fs::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    // 当前打开的文件描述符数，用于确认读写后没有遗留
+    size_t openFds() {
+        std::error_code ec;
+        const auto fds = fs::directory_iterator("/proc/self/fd", ec);
+        return ec ? 0 : static_cast<size_t>(std::distance(fds, fs::directory_iterator()));
+    }
+
+    // 各种大小的文件：空文件、小文件、跨多次读取的文件、超过上限的文件
+    size_t sizeOf(const size_t i) {
+        constexpr size_t sizes[] = {0, 1, 100, 4096, 65537, 200000, kMaxSize, kMaxSize + 1};
+        return sizes[i % std::size(sizes)];
+    }
+
+    void checkBackend(const std::string& kind, const fs::path& dir, const size_t count) {
+        const size_t fds = openFds();
+        const auto io = IoBackend::create(kind, 16);
+        std::cout << kind << " -> " << io->name() << "\n";
+
+        // 读取：内容与磁盘一致，超过上限的只标记 deferred，不存在的文件报告 ENOENT
+        WorkQueue<fs::path> paths;
+        WorkQueue<IoFile> loaded;
+        for (size_t i = 0; i < count; ++i) {
+            paths.push(dir / (std::to_string(i) + ".md"));
+        }
+        paths.push(dir / "missing.md");
+        paths.close();
+        std::thread reader([&] {
+            io->readFiles(paths, loaded, kMaxSize);
+            loaded.close();
+        });
+        std::set<std::string> seen;
+        while (auto file = loaded.pop()) {
+            const std::string name = file->path.filename().string();
+            seen.insert(name);
+            if (name == "missing.md") {
+                CHECK(file->error == ENOENT);
+                continue;
+            }
+            const size_t i = std::stoul(name);
+            CHECK(file->error == 0);
+            CHECK(file->deferred == (sizeOf(i) > kMaxSize));
+            if (!file->deferred) {
+                CHECK_TEXT(file->data, contentOf(i, sizeOf(i)));
+            }
+        }
+        reader.join();
+        CHECK(seen.size() == count + 1);
+
+        // 写回：截断后写入新内容，父文件夹不存在的文件放入 failed
+        WorkQueue<IoFile> toWrite;
+        std::vector<IoFile> failed;
+        std::thread writer([&] {
+            io->writeFiles(toWrite, failed);
+        });
+        for (size_t i = 0; i < count; ++i) {
+            toWrite.push(IoFile{dir / (std::to_string(i) + ".md"), contentOf(i + count, sizeOf(i) / 2)});
+        }
+        toWrite.push(IoFile{dir / "no-such-dir" / "x.md", "x"});
+        toWrite.close();
+        writer.join();
+        CHECK(failed.size() == 1 && failed[0].path.filename() == "x.md" && failed[0].error != 0);
+        for (size_t i = 0; i < count; ++i) {
+            const fs::path path = dir / (std::to_string(i) + ".md");
+            CHECK_TEXT(readAll(path), contentOf(i + count, sizeOf(i) / 2));
+            std::ofstream(path, std::ios::binary | std::ios::trunc) << contentOf(i, sizeOf(i));
+        }
+        CHECK(openFds() == fds);
+    }
+}
+
+
+int main() {
+    const fs::path dir = fs::temp_directory_path() / ("mdtool_test_iobackend_" + std::to_string(::getpid()));
+    fs::create_directories(dir);
+    constexpr size_t count = 300;
+    for (size_t i = 0; i < count; ++i) {
+        std::ofstream(dir / (std::to_string(i) + ".md"), std::ios::binary) << contentOf(i, sizeOf(i));
+    }
+
+    for (const std::string kind : {"uring", "thread", "auto"}) {
+        checkBackend(kind, dir, count);
+    }
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    return check::result();
+}
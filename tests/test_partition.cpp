@@ -0,0 +1,115 @@
+//
+// Created by zerox on 2025/11/22.
+//
+
+// 分区并行与流式处理的结果必须与单线程处理整篇完全相同
+
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <unistd.h>
+
+#include "check.h"
+#include "tools/tools.h"
+
+
+namespace {
+    // 生成代码块密集的文档：``` 与 ~~~ 代码块、更长的栅栏、缩进的栅栏、行内 ```、CRLF 行，末尾留一个未闭合的代码块
+    std::string fenceHeavy(const size_t size, const unsigned seed) {
+        std::mt19937 rng(seed);
+        const auto pick = [&rng](const size_t n) {
+            return static_cast<size_t>(rng() % n);
+        };
+        const char* languages[] = {"", "cpp", "python", "js", "```"};
+        const char* lines[] = {"int x = 0;", "    indented();", "", "\t\ttabbed   ", "text ``` inside",
+                               "~~~ not a fence here", "# 标题 中文内容", "- item", "return 1;  "};
+        std::string doc;
+        doc.reserve(size + 4096);
+        while (doc.size() < size) {
+            const std::string nl = pick(7) == 0 ? "\r\n" : "\n";
+            switch (pick(6)) {
+                case 0:
+                case 1: {
+                    const std::string fence = pick(5) == 0 ? "````" : pick(4) == 0 ? "~~~" : "```";
+                    const std::string indent = pick(8) == 0 ? "  " : "";
+                    doc += indent + fence + languages[pick(std::size(languages))] + nl;
+                    for (size_t n = pick(12); n > 0; --n) {
+                        doc += lines[pick(std::size(lines))] + nl;
+                    }
+                    doc += indent + fence + nl;
+                    break;
+                }
+                case 2:
+                    doc += "行内代码 ```a``` 与 `b`" + nl;
+                    break;
+                default:
+                    for (size_t n = pick(6) + 1; n > 0; --n) {
+                        doc += "正文 paragraph text " + std::to_string(rng()) + nl;
+                    }
+                    doc += nl;
+            }
+        }
+        doc += "```cpp\nunclosed();\n";
+        return doc;
+    }
+
+    InputOptions optionsFor(const std::string& option, const int jobs) {
+        InputOptions options;
+        options.option = option;
+        options.jobs = jobs;
+        options.input = "// added";
+        options.number = 1;
+        return options;
+    }
+
+    std::string readAll(const fs::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::ostringstream out;
+        out << in.rdbuf();
+        return out.str();
+    }
+
+    void writeAll(const fs::path& path, const std::string_view data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+}
+
+
+int main() {
+    const fs::path dir = fs::temp_directory_path() / ("mdtool_test_partition_" + std::to_string(::getpid()));
+    fs::create_directories(dir);
+    const std::string ops[] = {"cb.li add cpp", "cb.ct add", "cb.ct del 1 1", "cb.ct del", "cb.ct format"};
+
+    for (const unsigned seed : {1u, 2u, 3u}) {
+        // 6 MB 以上才会按 1 MB 的最小分区切成多个分区
+        const std::string doc = fenceHeavy(6 << 20, seed);
+        for (const auto& op : ops) {
+            std::string serial;
+            const auto expected = tools::transform(doc, optionsFor(op, 1), serial);
+            CHECK(expected.success);
+
+            std::string parallel;
+            const auto rt = tools::transform(doc, optionsFor(op, 8), parallel);
+            CHECK(rt.success);
+            CHECK(rt.modified == expected.modified);
+            CHECK_TEXT(parallel, serial);
+
+            // 流式处理按窗口读入、窗口内再分区，与单线程整篇读入的结果比较(两者都会统一换行符)
+            const fs::path file = dir / "doc.md";
+            writeAll(file, doc);
+            CHECK(tools::processFile(file, optionsFor(op, 1)).success);
+            const std::string whole = readAll(file);
+
+            writeAll(file, doc);
+            auto options = optionsFor(op, 8);
+            options.kStreamThreshold = 1;
+            CHECK(tools::processFile(file, options).success);
+            CHECK_TEXT(readAll(file), whole);
+        }
+    }
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    return check::result();
+}
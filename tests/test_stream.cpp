@@ -0,0 +1,112 @@
+//
+// Created by zerox on 2025/11/22.
+//
+
+// 流式处理：窗口边界切开 CRLF、多字节字符与代码块时结果与整篇处理相同；超长代码块原样保留且不打乱之后的配对
+
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#include "check.h"
+#include "tools/tools.h"
+#include "tools/tool_core/CodeBlock.h"
+#include "tools/tool_core/StreamProcessor.h"
+
+
+namespace {
+    std::string readAll(const fs::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::ostringstream out;
+        out << in.rdbuf();
+        return out.str();
+    }
+
+    void writeAll(const fs::path& path, const std::string_view data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    InputOptions optionsFor(const std::string& option, const uintmax_t streamThreshold) {
+        InputOptions options;
+        options.option = option;
+        options.jobs = 1;
+        options.input = "// added";
+        options.kStreamThreshold = streamThreshold;
+        return options;
+    }
+
+    // 把 s 填充到 size 字节，填充内容为普通段落
+    void fillTo(std::string& s, const size_t size) {
+        while (s.size() + 16 < size) {
+            s += "plain paragraph\n";
+        }
+        s.append(size - s.size(), 'x');
+    }
+
+    std::string transformed(const std::string_view text, const std::string& option) {
+        std::string out;
+        CHECK(tools::transform(text, optionsFor(option, 0), out).success);
+        return out;
+    }
+}
+
+
+int main() {
+    // 结束标记为开始行之后的第一个 ```，与 codeBlockRegex 相同
+    bool inBody = false;
+    CHECK(CodeBlock::streamSkip("```cpp ``` same line", inBody) == std::string_view::npos);
+    CHECK(!inBody);
+    CHECK(CodeBlock::streamSkip(" more\nbody\n```tail", inBody) == 14);
+    CHECK(inBody);
+    inBody = false;
+    CHECK(CodeBlock::streamSkip("```\n```", inBody) == 7);
+    inBody = true;
+    CHECK(CodeBlock::streamSkip("body only``", inBody) == std::string_view::npos);
+
+    const fs::path dir = fs::temp_directory_path() / ("mdtool_test_stream_" + std::to_string(::getpid()));
+    fs::create_directories(dir);
+    const fs::path file = dir / "doc.md";
+    constexpr size_t chunk = StreamProcessor::kChunkSize;
+
+    // 读取块的边界依次落在 CRLF 中间、多字节字符中间、代码块中间
+    {
+        std::string doc = "\xEF\xBB\xBF# 标题\r\n\r\n";
+        fillTo(doc, chunk - 1);
+        doc += "\r\n中文\n";
+        fillTo(doc, 2 * chunk - 1);
+        doc += "中文\n```cpp\n";
+        fillTo(doc, 3 * chunk);
+        doc += "\nint x;  \n```\n```\nlast\n```\n";
+        for (const std::string op : {"cb.ct add", "cb.ct format", "cb.li add py"}) {
+            writeAll(file, doc);
+            CHECK(tools::processFile(file, optionsFor(op, UINTMAX_MAX)).success);
+            const std::string whole = readAll(file);
+
+            writeAll(file, doc);
+            CHECK(tools::processFile(file, optionsFor(op, 1)).success);
+            CHECK_TEXT(readAll(file), whole);
+        }
+    }
+
+    // 超过预读上限的代码块原样保留，之后的代码块仍按整篇处理的配对处理
+    {
+        const std::string before = "intro\n";
+        std::string block = "```cpp\n";
+        fillTo(block, StreamProcessor::kMaxLookAhead + chunk);
+        block += "\n```";
+        const std::string after = "\ntext\n```\nbody\n```\nnot code\n```\ncode\n```\n";
+        writeAll(file, before + block + after);
+        const auto rt = tools::processFile(file, optionsFor("cb.ct add", 1));
+        CHECK(rt.success);
+        CHECK(std::ranges::any_of(rt.logs, [](const logs::alog& log) {
+            return std::get<0>(log) == LOG_TYPE::Warn;
+        }));
+        const std::string expected = transformed(before, "cb.ct add") + block + transformed(after, "cb.ct add");
+        CHECK_TEXT(readAll(file), expected);
+    }
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    return check::result();
+}
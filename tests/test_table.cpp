@@ -0,0 +1,64 @@
+//
+// Created by zerox on 2025/11/22.
+//
+
+// tb format：按显示宽度对齐、保留多出的单元格、忽略代码块中的表格
+
+#include "check.h"
+#include "tools/tool_core/Table.h"
+
+
+namespace {
+    std::string format(const std::string_view text, bool& modified) {
+        std::string out;
+        modified = Table().format(text, [&out](const std::string_view part) {
+            out.append(part);
+        });
+        return out;
+    }
+
+    std::string format(const std::string_view text) {
+        bool modified = false;
+        return format(text, modified);
+    }
+}
+
+
+int main() {
+    // 东亚宽字符计 2 列，分隔行保留对齐标记
+    CHECK_TEXT(format("| a | b |\n|---|:-:|\n| 中文 | x |\n"),
+               "| a    |  b  |\n"
+               "| ---- | :-: |\n"
+               "| 中文 |  x  |\n");
+
+    // 正文行多出的单元格原样接在行末，缺少的单元格补空
+    CHECK_TEXT(format("|a|b|\n|:--|--:|\n|1|2|3|4|\n|5|\n"),
+               "| a   |   b |\n"
+               "| :-- | --: |\n"
+               "| 1   |   2 | 3 | 4 |\n"
+               "| 5   |     |\n");
+
+    // 缩进与正文保持不变
+    CHECK_TEXT(format("text\n\n  | x | y |\n  | - | - |\n  | 1 | 2 |\n\nmore\n"),
+               "text\n\n"
+               "  | x   | y   |\n"
+               "  | --- | --- |\n"
+               "  | 1   | 2   |\n"
+               "\nmore\n");
+
+    // 代码块中的表格不处理
+    bool modified = true;
+    const std::string fenced = "```\n|a|b|\n|-|-|\n```\n";
+    CHECK_TEXT(format(fenced, modified), fenced);
+    CHECK(!modified);
+
+    // 已对齐的表格再次格式化不发生修改
+    const std::string aligned = format("| 名称 | value |\n|:-|-:|\n| x | 12 |\n");
+    CHECK_TEXT(format(aligned, modified), aligned);
+    CHECK(!modified);
+
+    CHECK(Table::displayWidth("abc") == 3);
+    CHECK(Table::displayWidth("中文") == 4);
+    CHECK(Table::displayWidth("e\xCC\x81") == 1);   // 组合字符不占宽度
+    return check::result();
+}
@@ -4,10 +4,410 @@
 
 #include "CodeBlock.h"
 
+#include <algorithm>
+#include <bit>
 
-const RE2 CodeBlock::codeBlockRegex(R"(```([ \t]*)([^ \t\n]*)([^\n]*)\n([\s\S]*?)([ \t]*)```)");
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 
+encoding CodeBlock::enc;
+
+
+const RE2& CodeBlock::codeBlockRegex() {
+    static const RE2 regex(R"(```([ \t]*)([^ \t\n]*)([^\n]*)\n([\s\S]*?)([ \t]*)```)");
+    return regex;
+}
+
+
+namespace {
+    bool isSpace(const char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+    }
+
+    // 去除行尾空白后的长度；SSE2 每次从行尾向前判断 16 个字节，空白字符与 isSpace 相同
+    size_t trimmedLength(const std::string_view line) {
+        size_t n = line.size();
+#if defined(__SSE2__)
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i cr = _mm_set1_epi8('\r');
+        const __m128i ff = _mm_set1_epi8('\f');
+        const __m128i vt = _mm_set1_epi8('\v');
+        while (n >= 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(line.data() + n - 16));
+            const __m128i ws = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_or_si128(_mm_cmpeq_epi8(v, ff), _mm_cmpeq_epi8(v, vt))));
+            const auto mask = static_cast<unsigned>(_mm_movemask_epi8(ws));
+            if (mask != 0xFFFF) {
+                // 最高位的非空白字节即为最后一个有效字符
+                return n - 16 + (32 - static_cast<size_t>(std::countl_zero(~mask & 0xFFFFu)));
+            }
+            n -= 16;
+        }
+#endif
+        while (n > 0 && isSpace(line[n - 1])) {
+            --n;
+        }
+        return n;
+    }
+
+    // 行首缩进所占的列数
+    size_t indentColumns(const std::string_view line, const size_t tabWidth) {
+        size_t col = 0;
+        for (const char c : line) {
+            if (c == ' ') {
+                ++col;
+            } else if (c == '\t') {
+                col += tabWidth - col % tabWidth;
+            } else {
+                break;
+            }
+        }
+        return col;
+    }
+
+    // 去除 columns 列缩进，tab 跨越边界时用空格补齐剩余的列
+    void appendDedented(std::string& out, const std::string_view line, const size_t columns, const size_t tabWidth) {
+        size_t col = 0;
+        size_t i = 0;
+        while (i < line.size() && col < columns) {
+            if (line[i] == ' ') {
+                ++col;
+            } else if (line[i] == '\t') {
+                col += tabWidth - col % tabWidth;
+            } else {
+                break;
+            }
+            ++i;
+        }
+        if (col > columns) {
+            out.append(col - columns, ' ');
+        }
+        out.append(line.substr(i));
+    }
+
+    // 按 \n 拆分代码块内容；以换行结尾时最后的空串不计为一行
+    std::vector<std::string_view> splitLines(const std::string_view body, bool& trailingNewline) {
+        std::vector<std::string_view> lines;
+        size_t pos = 0;
+        while (pos < body.size()) {
+            const size_t nl = body.find('\n', pos);
+            if (nl == std::string_view::npos) {
+                lines.push_back(body.substr(pos));
+                pos = body.size();
+                break;
+            }
+            lines.push_back(body.substr(pos, nl - pos));
+            pos = nl + 1;
+        }
+        trailingNewline = !body.empty() && body.back() == '\n';
+        return lines;
+    }
+
+    std::string joinLines(const std::vector<std::string_view>& lines, const bool trailingNewline) {
+        std::string out;
+        for (size_t i = 0; i < lines.size(); ++i) {
+            out.append(lines[i]);
+            if (i + 1 < lines.size() || trailingNewline) {
+                out.push_back('\n');
+            }
+        }
+        return out;
+    }
+}
+
+
+bool CodeBlock::rewriteBodies(const std::string_view text, const TextSink& sink, const BodyFunc& f) {
+    // 没有代码块时原样输出，不编译也不运行正则
+    if (text.find("```") == std::string_view::npos) {
+        sink(text);
+        return false;
+    }
+
+    bool has_modification = false;
+    re2::StringPiece input(text.data(), text.size());
+    re2::StringPiece leading_space, lang, rest_of_line, code_content;
+    size_t last_end = 0;
+
+    while (RE2::FindAndConsume(&input, codeBlockRegex(), &leading_space, &lang, &rest_of_line, &code_content)) {
+        const std::string_view body(code_content.data(), code_content.size());
+        auto replaced = f(body);
+        if (!replaced || *replaced == body) {
+            continue;
+        }
+
+        const size_t body_start = static_cast<size_t>(body.data() - text.data());
+        sink(text.substr(last_end, body_start - last_end));
+        sink(*replaced);
+        last_end = body_start + body.size();
+        has_modification = true;
+    }
+
+    sink(text.substr(last_end));
+    return has_modification;
+}
+
+void CodeBlock::forEach(const std::string_view text, const std::function<void(const Block&)>& f) {
+    if (text.find("```") == std::string_view::npos) {
+        return;
+    }
+
+    re2::StringPiece input(text.data(), text.size());
+    re2::StringPiece leading_space, lang, rest_of_line, code_content;
+    size_t line = 1;
+    size_t counted = 0;
+    while (RE2::FindAndConsume(&input, codeBlockRegex(), &leading_space, &lang, &rest_of_line, &code_content)) {
+        // 行号只统计上一个代码块之后到本代码块开头之间的换行
+        const size_t fence = static_cast<size_t>(leading_space.data() - text.data()) - 3;
+        line += static_cast<size_t>(std::count(text.begin() + counted, text.begin() + fence, '\n'));
+        f({line, std::string_view(lang.data(), lang.size()), std::string_view(code_content.data(), code_content.size())});
+        counted = fence;
+    }
+}
+
+bool CodeBlock::CodeContent::add(const std::string_view text, const std::string& content, const int position,
+                                 const TextSink& sink) const {
+    return rewriteBodies(text, sink, [&](const std::string_view body) -> std::optional<std::string> {
+        bool trailingNewline = false;
+        auto lines = splitLines(body, trailingNewline);
+        const auto total = static_cast<int>(lines.size());
+        int index = position > 0 ? position - 1 : position < 0 ? total + position + 1 : 0;
+        index = std::clamp(index, 0, total);
+        lines.insert(lines.begin() + index, content);
+        // 原本为空的代码块插入后也需要换行，结束标记才能独占一行
+        return joinLines(lines, trailingNewline || body.empty());
+    });
+}
+
+bool CodeBlock::CodeContent::del(const std::string_view text, const size_t head, const size_t tail,
+                                 const TextSink& sink) const {
+    if (head == 0 && tail == 0) {
+        sink(text);
+        return false;
+    }
+    return rewriteBodies(text, sink, [&](const std::string_view body) -> std::optional<std::string> {
+        bool trailingNewline = false;
+        auto lines = splitLines(body, trailingNewline);
+        if (lines.empty()) {
+            return std::nullopt;
+        }
+        if (head + tail >= lines.size()) {
+            return std::string();
+        }
+        lines.erase(lines.end() - static_cast<std::ptrdiff_t>(tail), lines.end());
+        lines.erase(lines.begin(), lines.begin() + static_cast<std::ptrdiff_t>(head));
+        return joinLines(lines, trailingNewline);
+    });
+}
+
+bool CodeBlock::CodeContent::format(const std::string_view text, const TextSink& sink) const {
+    return rewriteBodies(text, sink, [](const std::string_view body) -> std::optional<std::string> {
+        bool trailingNewline = false;
+        auto lines = splitLines(body, trailingNewline);
+
+        // 行尾空白
+        for (auto& line : lines) {
+            line = line.substr(0, trimmedLength(line));
+        }
+
+        // 首尾空行
+        size_t first = 0;
+        size_t last = lines.size();
+        while (first < last && lines[first].empty()) {
+            ++first;
+        }
+        while (last > first && lines[last - 1].empty()) {
+            --last;
+        }
+        if (first == last) {
+            return std::string();
+        }
+
+        // 公共缩进
+        size_t indent = std::string::npos;
+        for (size_t i = first; i < last; ++i) {
+            if (!lines[i].empty()) {
+                indent = std::min(indent, indentColumns(lines[i], kTabWidth));
+            }
+        }
+
+        std::string out;
+        out.reserve(body.size());
+        bool previousBlank = false;
+        for (size_t i = first; i < last; ++i) {
+            const bool blank = lines[i].empty();
+            if (blank && previousBlank) {
+                continue;
+            }
+            previousBlank = blank;
+            appendDedented(out, lines[i], indent, kTabWidth);
+            out.push_back('\n');
+        }
+        if (!trailingNewline) {
+            out.pop_back();
+        }
+        return out;
+    });
+}
+
+
+size_t CodeBlock::streamCut(const std::string_view buffer) {
+    re2::StringPiece input(buffer.data(), buffer.size());
+    while (RE2::FindAndConsume(&input, codeBlockRegex())) {
+    }
+    // 最后一个匹配之后的内容中，只有从 ``` 开始的部分可能与后续数据组成新的代码块
+    const size_t last_end = buffer.size() - input.size();
+    const size_t fence = buffer.find("```", last_end);
+    // 末尾两个字符可能是被切开的 ```
+    const size_t limit = buffer.size() >= 2 ? buffer.size() - 2 : 0;
+    return std::min(fence, std::max(limit, last_end));
+}
+
+size_t CodeBlock::streamSkip(const std::string_view buffer, bool& inBody) {
+    size_t pos = 0;
+    if (!inBody) {
+        const size_t newline = buffer.find('\n');
+        if (newline == std::string_view::npos) {
+            return std::string_view::npos;
+        }
+        inBody = true;
+        pos = newline + 1;
+    }
+    const size_t close = buffer.find("```", pos);
+    return close == std::string_view::npos ? close : close + 3;
+}
+
+std::vector<std::pair<size_t, size_t>> CodeBlock::spans(const std::string_view text) {
+    std::vector<std::pair<size_t, size_t>> result;
+    re2::StringPiece input(text.data(), text.size());
+    re2::StringPiece leading_space;
+    while (RE2::FindAndConsume(&input, codeBlockRegex(), &leading_space)) {
+        const size_t start = static_cast<size_t>(leading_space.data() - text.data()) - 3;
+        result.emplace_back(start, text.size() - input.size());
+    }
+    return result;
+}
+
+std::vector<size_t> CodeBlock::findFences(const std::string_view text) {
+    std::vector<size_t> fences;
+    const char* p = text.data();
+    const size_t n = text.size();
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // 每次比较 16 个起点：p[i]、p[i+1]、p[i+2] 同时为 ` 的位置即为 ``` 的起点
+    const __m128i tick = _mm_set1_epi8('`');
+    for (; i + 18 <= n; i += 16) {
+        const __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)), tick);
+        const __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 1)), tick);
+        const __m128i c = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 2)), tick);
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(a, _mm_and_si128(b, c))));
+        while (mask) {
+            fences.push_back(i + static_cast<size_t>(std::countr_zero(mask)));
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i + 3 <= n; ++i) {
+        if (p[i] == '`' && p[i + 1] == '`' && p[i + 2] == '`') {
+            fences.push_back(i);
+        }
+    }
+    return fences;
+}
+
+std::vector<size_t> CodeBlock::partition(const std::string_view text, const size_t parts) {
+    std::vector<size_t> starts{0};
+    if (parts < 2 || text.empty()) {
+        return starts;
+    }
+
+    // 按 codeBlockRegex 的规则在 ``` 位置上配对：
+    // 开始标记为 pos 之后第一个 ```，其后第一个换行之后的第一个 ``` 为结束标记
+    const auto fences = findFences(text);
+    size_t k = 1;
+    size_t target = text.size() / parts;
+    const auto nextTarget = [&] {
+        ++k;
+        target = text.size() / parts * k;
+    };
+    const auto push = [&](const size_t at) {
+        if (at > starts.back() && at < text.size()) {
+            starts.push_back(at);
+        }
+    };
+
+    size_t pos = 0;
+    auto it = fences.begin();
+    while (k < parts) {
+        it = std::lower_bound(it, fences.end(), pos);
+        if (it == fences.end()) {
+            break;
+        }
+        const size_t open = *it;
+        const size_t newline = text.find('\n', open + 3);
+        if (newline == std::string_view::npos) {
+            break;
+        }
+        const auto closing = std::lower_bound(it, fences.end(), newline + 1);
+        if (closing == fences.end()) {
+            break;
+        }
+        const size_t end = *closing + 3;
+
+        // 代码块之间的空隙可以任意切分，落在代码块内的切分点推迟到代码块末尾
+        for (; k < parts && target < open; nextTarget()) {
+            push(target);
+        }
+        for (; k < parts && target < end; nextTarget()) {
+            push(end);
+        }
+        pos = end;
+        it = closing;
+    }
+    // 之后不会再有完整的代码块
+    for (; k < parts; nextTarget()) {
+        push(std::max(target, pos));
+    }
+    return starts;
+}
+
+
+bool CodeBlock::LanguageIdentifier::add(const std::string_view text, const std::string& language,
+                                        const TextSink& sink) const {
+    if (text.find("```") == std::string_view::npos) {
+        sink(text);
+        return false;
+    }
+
+    bool has_modification = false;
+    re2::StringPiece input(text.data(), text.size());
+    re2::StringPiece leading_space, lang, rest_of_line, code_content, trailing_space;
+    size_t last_end = 0;
+
+    while (RE2::FindAndConsume(&input, codeBlockRegex(), &leading_space, &lang, &rest_of_line, &code_content, &trailing_space)) {
+        // 已有语言标识则保持原样，继续向后匹配
+        if (!lang.empty()) {
+            continue;
+        }
+
+        // 语言标识插入在 ``` 与前导空白之后，之前的内容原样交给 sink
+        const size_t insert_pos = static_cast<size_t>(lang.data() - text.data());
+        sink(text.substr(last_end, insert_pos - last_end));
+        sink(language);
+        last_end = insert_pos;
+        has_modification = true;
+    }
+
+    // 添加最后一个修改点之后的内容
+    sink(text.substr(last_end));
+    return has_modification;
+}
+
 FinalFuncReturn CodeBlock::LanguageIdentifier::add(const fs::path& path, const std::string& language, const int& start) {
     FinalFuncReturn rt;
     auto filename = reinterpret_cast<const char *>(path.c_str());
@@ -23,68 +423,31 @@ FinalFuncReturn CodeBlock::LanguageIdentifier::add(const fs::path& path, const s
         rt.logs = {logs::alog(LOG_TYPE::Error,"读取文件为utf8遇到错误")};
         return rt;
     }
-    auto text = tool::splitFromLine(*data, start);
-
-    std::string content = start > 0 ? std::get<1>(text) : std::get<0>(text);
+    const std::string_view text(*data);
+    const size_t split_pos = tool::splitPos(text, start);
 
+    // start > 0 处理分割后的第二部分，否则处理第一部分
+    const std::string_view head = start > 0 ? text.substr(0, split_pos) : std::string_view();
+    const std::string_view content = start > 0 ? text.substr(split_pos) : text.substr(0, split_pos);
+    const std::string_view tail = start > 0 ? std::string_view() : text.substr(split_pos);
 
     std::string result;
-    bool has_modification = false;
-    re2::StringPiece input(content);
-    re2::StringPiece leading_space, lang, rest_of_line, code_content, trailing_space;
-    size_t last_end = 0;
-
-    while (RE2::FindAndConsume(&input, codeBlockRegex, &leading_space, &lang, &rest_of_line, &code_content, &trailing_space)) {
-        // 计算当前匹配的位置
-        size_t match_start = content.size() - input.size() -
-                            (3 + leading_space.size() + lang.size() + rest_of_line.size() + 1 +
-                             code_content.size() + trailing_space.size() + 3);
-
-        // 添加代码块之前的内容
-        result += content.substr(last_end, match_start - last_end);
-
-        // 如果没有语言标识，添加语言标记
-        if (lang.empty()) {
-            result += "```";
-            result.append(leading_space.data(), leading_space.size());
-            result += language;
-            result.append(rest_of_line.data(), rest_of_line.size());
-            result += "\n";
-            result.append(code_content.data(), code_content.size());
-            result.append(trailing_space.data(), trailing_space.size());
-            result += "```";
-            has_modification = true;
-        } else {
-            // 保持原样
-            result += "```";
-            result.append(leading_space.data(), leading_space.size());
-            result.append(lang.data(), lang.size());
-            result.append(rest_of_line.data(), rest_of_line.size());
-            result += "\n";
-            result.append(code_content.data(), code_content.size());
-            result.append(trailing_space.data(), trailing_space.size());
-            result += "```";
-        }
-
-        last_end = content.size() - input.size();
-    }
+    result.reserve(text.size() + 64);
+    result.append(head);
+    const bool has_modification = add(content, language, [&result](const std::string_view part) {
+        result.append(part);
+    });
+    result.append(tail);
 
     if (has_modification) {
-        // 添加最后一个代码块之后的内容
-        result += content.substr(last_end);
-        if (start > 0) {
-            std::get<1>(text) = result;
-        } else {
-            std::get<0>(text) = result;
-        }
-
-        bool save = enc.saveUtf8ToFile(filename, std::get<0>(text) + std::get<1>(text), *charset);
+        bool save = enc.saveUtf8ToFile(filename, result, *charset);
         if (!save) {
             rt.success = false;
             rt.logs = {logs::alog(LOG_TYPE::Error, "保存失败：" + std::string(filename))};
             return rt;
         }
         rt.success = true;
+        rt.modified = true;
         rt.logs = {logs::alog(LOG_TYPE::Info, "处理完成：" + std::string(filename))};
 
         return rt;
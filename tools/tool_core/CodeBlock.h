@@ -11,10 +11,14 @@
 
 // md代码块操作类
 class CodeBlock {
-    static const RE2 codeBlockRegex;
+    // 首次使用时才编译，只读 tb 或解析失败的调用不付出编译开销
+    static const RE2& codeBlockRegex();
     static encoding enc;
     class LanguageIdentifier {
     public:
+        // 内存接口：处理 utf8 文本，结果按顺序写入 sink，返回是否发生修改
+        bool add(std::string_view text, const std::string& language, const TextSink& sink) const;
+
         FinalFuncReturn add(const fs::path& path, const std::string& language, const int& start);
         bool upd(const fs::path& path, const std::string& language);
         bool del(const fs::path& path);
@@ -24,13 +28,53 @@ class CodeBlock {
 
     class CodeContent {
     public:
-        bool add(const fs::path& path, const std::string& content);
-        bool del(const fs::path& path);
-        bool format(const fs::path& path);
+        // 以下均为内存接口：处理 utf8 文本，结果按顺序写入 sink，返回是否发生修改
+        // 在代码块第 position 行之前插入 content，position < 0 表示倒数第 -position 行之后，0 等同于 1
+        bool add(std::string_view text, const std::string& content, int position, const TextSink& sink) const;
+        // 删除代码块开头 head 行与结尾 tail 行
+        bool del(std::string_view text, size_t head, size_t tail, const TextSink& sink) const;
+        // 去除行尾空白、首尾空行，合并连续空行，并去除公共缩进(tab 按 kTabWidth 列计算)
+        bool format(std::string_view text, const TextSink& sink) const;
+
+        static constexpr size_t kTabWidth = 4;
     };
 
+    // 代码块内容改写函数：返回 nullopt 表示该代码块保持原样
+    using BodyFunc = std::function<std::optional<std::string>(std::string_view body)>;
+
+    // 对每个代码块的内容调用 f，只替换被改写的内容，其余部分直接引用 text
+    static bool rewriteBodies(std::string_view text, const TextSink& sink, const BodyFunc& f);
+
 public:
      CodeBlock() {}
+
+    // 流式处理的窗口切分点：最后一个完整代码块之后、下一个 ``` 之前
+    // 切分点之前的匹配结果与整篇处理完全一致
+    static size_t streamCut(std::string_view buffer);
+
+    // 流式处理中跳过超长的未闭合代码块：与 codeBlockRegex 相同，开始行之后的第一个 ``` 为结束标记
+    static size_t streamSkip(std::string_view buffer, bool& inBody);
+
+    // 所有代码块在 text 中的范围 [起点, 终点)，按出现顺序排列
+    static std::vector<std::pair<size_t, size_t>> spans(std::string_view text);
+
+    // SIMD 预扫描所有 ``` 出现的位置(允许重叠)
+    static std::vector<size_t> findFences(std::string_view text);
+
+    // 单个代码块的位置与内容，均直接引用输入文本
+    struct Block {
+        size_t line;                 // 开头 ``` 所在行，从 1 开始
+        std::string_view language;
+        std::string_view body;
+    };
+
+    // 按出现顺序对每个代码块调用 f
+    static void forEach(std::string_view text, const std::function<void(const Block&)>& f);
+
+    // 按代码块边界把 text 切分为至多 parts 个互不影响的分区，返回各分区起点(首个为 0)
+    // 各分区单独匹配的结果与整篇匹配完全一致
+    static std::vector<size_t> partition(std::string_view text, size_t parts);
+
     LanguageIdentifier li;
     CodeContent ct;
 };
@@ -0,0 +1,354 @@
+//
+// Created by zerox on 2025/11/19.
+//
+
+#include "CodeExport.h"
+
+#include <algorithm>
+#include <random>
+#include <unordered_set>
+
+#include "CodeBlock.h"
+
+
+namespace {
+    constexpr auto kManifest = "manifest.ndjson";
+
+    // 内容文件的临时文件名：进程内随机前缀加计数，同时运行的多个线程或进程不会写同一个临时文件
+    std::string tempSuffix() {
+        static const std::string prefix = ".tmp" + std::to_string(std::random_device{}());
+        static std::atomic<unsigned> counter = 0;
+        return prefix + "." + std::to_string(counter++);
+    }
+
+    void appendJsonString(std::string& out, const std::string_view s) {
+        static constexpr char digits[] = "0123456789abcdef";
+        out += '"';
+        for (const char c : s) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        out += "\\u00";
+                        out += digits[c >> 4];
+                        out += digits[c & 0xF];
+                    } else {
+                        out += c;
+                    }
+            }
+        }
+        out += '"';
+    }
+
+    void appendUtf8(std::string& out, const uint32_t cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | cp >> 6);
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | cp >> 12);
+            out += static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | cp >> 18);
+            out += static_cast<char>(0x80 | (cp >> 12 & 0x3F));
+            out += static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    // 读取一个 JSON 字符串，s 指向开头的引号，结束后指向结尾引号之后
+    std::optional<std::string> readJsonString(std::string_view& s) {
+        if (s.empty() || s.front() != '"') {
+            return std::nullopt;
+        }
+        s.remove_prefix(1);
+        std::string out;
+        while (!s.empty()) {
+            const char c = s.front();
+            s.remove_prefix(1);
+            if (c == '"') {
+                return out;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (s.empty()) {
+                return std::nullopt;
+            }
+            const char e = s.front();
+            s.remove_prefix(1);
+            switch (e) {
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    if (s.size() < 4) {
+                        return std::nullopt;
+                    }
+                    const auto cp = static_cast<uint32_t>(std::stoul(std::string(s.substr(0, 4)), nullptr, 16));
+                    s.remove_prefix(4);
+                    appendUtf8(out, cp);
+                    break;
+                }
+                default: out += e;
+            }
+        }
+        return std::nullopt;
+    }
+}
+
+
+std::string CodeExport::toJson(const Record& record) {
+    std::string out = "{\"file\":";
+    appendJsonString(out, record.file);
+    out += ",\"line\":" + std::to_string(record.line) + ",\"language\":";
+    appendJsonString(out, record.language);
+    out += ",\"hash\":\"" + record.hash + "\"}";
+    return out;
+}
+
+std::optional<CodeExport::Record> CodeExport::fromJson(std::string_view line) {
+    // 只解析本工具写出的扁平对象：字符串或非负整数值
+    Record record;
+    const auto skipSpace = [&] {
+        while (!line.empty() && (line.front() == ' ' || line.front() == '\t' || line.front() == '\r')) {
+            line.remove_prefix(1);
+        }
+    };
+    skipSpace();
+    if (line.empty() || line.front() != '{') {
+        return std::nullopt;
+    }
+    line.remove_prefix(1);
+    while (true) {
+        skipSpace();
+        if (!line.empty() && line.front() == '}') {
+            break;
+        }
+        const auto key = readJsonString(line);
+        skipSpace();
+        if (!key || line.empty() || line.front() != ':') {
+            return std::nullopt;
+        }
+        line.remove_prefix(1);
+        skipSpace();
+        if (!line.empty() && line.front() == '"') {
+            auto value = readJsonString(line);
+            if (!value) {
+                return std::nullopt;
+            }
+            if (*key == "file") record.file = std::move(*value);
+            else if (*key == "language") record.language = std::move(*value);
+            else if (*key == "hash") record.hash = std::move(*value);
+        } else {
+            size_t n = 0;
+            size_t digits = 0;
+            while (digits < line.size() && std::isdigit(static_cast<unsigned char>(line[digits]))) {
+                n = n * 10 + static_cast<size_t>(line[digits] - '0');
+                ++digits;
+            }
+            if (digits == 0) {
+                return std::nullopt;
+            }
+            line.remove_prefix(digits);
+            if (*key == "line") record.line = n;
+        }
+        skipSpace();
+        if (!line.empty() && line.front() == ',') {
+            line.remove_prefix(1);
+        }
+    }
+    if (record.file.empty() || record.hash.size() != 64) {
+        return std::nullopt;
+    }
+    return record;
+}
+
+fs::path CodeExport::blobPath(const std::string& hash) const {
+    return dir / hash.substr(0, 2) / hash.substr(2);
+}
+
+bool CodeExport::store(const std::string& hash, const std::string_view body, std::string& error) {
+    if (seen.contains(hash)) {
+        return true;
+    }
+    // 按内容寻址：文件已存在即内容相同，不重写也不改动修改时间
+    const fs::path path = blobPath(hash);
+    std::error_code ec;
+    if (fs::exists(path, ec)) {
+        seen.insert(hash);
+        return true;
+    }
+    fs::create_directories(path.parent_path(), ec);
+
+    // 先写临时文件再改名，中断时不会留下不完整的内容文件
+    // 内容文件就位后才记入 seen：其他线程在此之前遇到同一哈希时各自写入，改名后内容相同，
+    // 不会在内容文件写完之前就认为它已存在，写入失败时也不会让其他文件引用不存在的内容
+    fs::path tmp = path;
+    tmp += tempSuffix();
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        file.write(body.data(), static_cast<std::streamsize>(body.size()));
+        file.close();
+        if (file.fail()) {
+            fs::remove(tmp, ec);
+            error = "写入导出内容失败：" + path.string();
+            return false;
+        }
+    }
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        error = "写入导出内容失败：" + path.string();
+        return false;
+    }
+    if (seen.insert(hash)) {
+        ++created;
+    }
+    return true;
+}
+
+FinalFuncReturn CodeExport::add(const std::string& file, const std::string_view text) {
+    FinalFuncReturn rt;
+    std::vector<Record> found;
+    std::string error;
+    CodeBlock::forEach(text, [&](const CodeBlock::Block& block) {
+        if (!error.empty()) {
+            return;
+        }
+        Record record{file, block.line, std::string(block.language), tool::sha256(block.body)};
+        if (store(record.hash, block.body, error)) {
+            found.push_back(std::move(record));
+        }
+    });
+    if (!error.empty()) {
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, error)};
+        return rt;
+    }
+
+    blocks += found.size();
+    const size_t count = found.size();
+    {
+        std::lock_guard lock(mutex);
+        records[file] = std::move(found);
+    }
+    rt.success = true;
+    rt.logs = {logs::alog(LOG_TYPE::Info, "导出 " + std::to_string(count) + " 个代码块：" + file)};
+    return rt;
+}
+
+FinalFuncReturn CodeExport::finish(const bool partial) {
+    FinalFuncReturn rt;
+    const fs::path manifestPath = dir / kManifest;
+
+    // 只处理部分文件时，旧清单中本次没有处理到的文件原样保留，使清单仍然完整
+    std::string previous;
+    std::vector<Record> merged;
+    std::unordered_set<std::string> oldHashes;
+    if (std::ifstream in(manifestPath, std::ios::binary); in.is_open()) {
+        previous.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        std::string_view rest = previous;
+        while (!rest.empty()) {
+            const auto eol = rest.find('\n');
+            const std::string_view line = rest.substr(0, eol);
+            rest = eol == std::string_view::npos ? std::string_view{} : rest.substr(eol + 1);
+            if (auto record = fromJson(line)) {
+                oldHashes.insert(record->hash);
+                if (partial && !records.contains(record->file)) {
+                    merged.push_back(std::move(*record));
+                }
+            }
+        }
+    }
+    for (auto& [file, list] : records) {
+        std::move(list.begin(), list.end(), std::back_inserter(merged));
+    }
+    records.clear();
+    std::sort(merged.begin(), merged.end(), [](const Record& a, const Record& b) {
+        return std::tie(a.file, a.line) < std::tie(b.file, b.line);
+    });
+
+    std::string manifest;
+    std::unordered_set<std::string> referenced;
+    for (const auto& record : merged) {
+        manifest += toJson(record);
+        manifest += '\n';
+        referenced.insert(record.hash);
+    }
+
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (manifest != previous) {
+        fs::path tmp = manifestPath;
+        tmp += tempSuffix();
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(manifest.data(), static_cast<std::streamsize>(manifest.size()));
+        out.close();
+        if (!out.good() || (fs::rename(tmp, manifestPath, ec), ec)) {
+            fs::remove(tmp, ec);
+            rt.success = false;
+            rt.logs = {logs::alog(LOG_TYPE::Error, "写入清单失败：" + manifestPath.string())};
+            return rt;
+        }
+    }
+
+    // 只删除旧清单引用过、现在不再引用的内容，不清理目录中的其他文件
+    size_t removed = 0;
+    for (const auto& hash : oldHashes) {
+        if (!referenced.contains(hash) && fs::remove(blobPath(hash), ec)) {
+            ++removed;
+            fs::remove(blobPath(hash).parent_path(), ec);  // 目录为空时一并删除
+        }
+    }
+
+    rt.success = true;
+    rt.logs = {logs::alog(LOG_TYPE::MainInfo,
+        "导出代码块 " + std::to_string(blocks.load()) + " 个，新增内容 " + std::to_string(created.load()) +
+        " 个，删除内容 " + std::to_string(removed) + " 个，清单：" + manifestPath.string())};
+    return rt;
+}
+
+namespace {
+    std::mutex sessionMutex;
+    std::map<std::string, std::unique_ptr<CodeExport>> sessions;
+
+    std::string sessionKey(const fs::path& dir) {
+        std::error_code ec;
+        return fs::absolute(dir, ec).lexically_normal().string();
+    }
+}
+
+CodeExport& CodeExport::session(const fs::path& dir) {
+    std::lock_guard lock(sessionMutex);
+    auto& session = sessions[sessionKey(dir)];
+    if (!session) {
+        session = std::make_unique<CodeExport>(dir);
+    }
+    return *session;
+}
+
+FinalFuncReturn CodeExport::finishSession(const fs::path& dir, const bool partial) {
+    std::unique_ptr<CodeExport> session;
+    {
+        std::lock_guard lock(sessionMutex);
+        const auto it = sessions.find(sessionKey(dir));
+        if (it == sessions.end()) {
+            FinalFuncReturn rt;
+            rt.success = true;
+            return rt;
+        }
+        session = std::move(it->second);
+        sessions.erase(it);
+    }
+    return session->finish(partial);
+}
@@ -0,0 +1,59 @@
+//
+// Created by zerox on 2025/11/19.
+//
+
+#ifndef MDTOOL2_CODEEXPORT_H
+#define MDTOOL2_CODEEXPORT_H
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include "ConcurrentSet.h"
+#include "../../global.h"
+
+
+// 代码块导出：内容按 SHA-256 存为 <dir>/<前两位>/<其余位>，相同内容只存一份
+// 清单 <dir>/manifest.ndjson 每行记录一个代码块的 file、line、language、hash
+// 同一输出目录在一次运行中共享一个实例，多个线程同时调用 add
+class CodeExport {
+public:
+    struct Record {
+        std::string file;
+        size_t line = 0;
+        std::string language;
+        std::string hash;
+    };
+
+    explicit CodeExport(fs::path dir) : dir(std::move(dir)) {}
+
+    // 导出 text 中的全部代码块，file 为清单中记录的路径(以 / 分隔)
+    // 内容文件已存在时不再写入
+    FinalFuncReturn add(const std::string& file, std::string_view text);
+
+    // 写出清单(内容不变时不写)，并删除不再被引用的内容文件
+    // partial 为 true 时(如 --changed-since)保留旧清单中本次未处理文件的记录，否则丢弃
+    FinalFuncReturn finish(bool partial);
+
+    // 按输出目录取得本次运行的实例；finishSession 调用 finish 后移除实例
+    static CodeExport& session(const fs::path& dir);
+    static FinalFuncReturn finishSession(const fs::path& dir, bool partial);
+
+    static std::string toJson(const Record& record);
+    static std::optional<Record> fromJson(std::string_view line);
+
+private:
+    // 写入一份内容，内容文件就位后记入 seen，此后同一哈希不再检查
+    bool store(const std::string& hash, std::string_view body, std::string& error);
+    fs::path blobPath(const std::string& hash) const;
+
+    fs::path dir;
+    ConcurrentSet<std::string> seen;
+    std::atomic<size_t> blocks = 0;
+    std::atomic<size_t> created = 0;
+
+    std::mutex mutex;
+    std::map<std::string, std::vector<Record>> records;  // 本次处理过的文件，没有代码块的文件也占一项
+};
+
+
+#endif //MDTOOL2_CODEEXPORT_H
@@ -0,0 +1,59 @@
+//
+// Created by zerox on 2025/11/19.
+//
+
+#ifndef MDTOOL2_CONCURRENTSET_H
+#define MDTOOL2_CONCURRENTSET_H
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+
+
+// 分片加锁的并发集合：按哈希值分到 kShards 个分片，不同分片的插入互不阻塞
+template <typename T, typename Hash = std::hash<T>>
+class ConcurrentSet {
+public:
+    // 首次插入返回 true，已存在返回 false
+    bool insert(const T& value) {
+        Shard& shard = shardOf(value);
+        std::lock_guard lock(shard.mutex);
+        return shard.items.insert(value).second;
+    }
+
+    bool contains(const T& value) {
+        Shard& shard = shardOf(value);
+        std::lock_guard lock(shard.mutex);
+        return shard.items.contains(value);
+    }
+
+    size_t size() {
+        size_t total = 0;
+        for (auto& shard : shards) {
+            std::lock_guard lock(shard.mutex);
+            total += shard.items.size();
+        }
+        return total;
+    }
+
+private:
+    static constexpr size_t kShards = 64;
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_set<T, Hash> items;
+    };
+
+    Shard& shardOf(const T& value) {
+        // 低位通常已被 unordered_set 用于分桶，取高位分片
+        const size_t h = Hash{}(value);
+        return shards[(h >> (sizeof(size_t) * 8 - 6)) % kShards];
+    }
+
+    std::array<Shard, kShards> shards;
+};
+
+
+#endif //MDTOOL2_CONCURRENTSET_H
@@ -0,0 +1,385 @@
+//
+// Created by zerox on 2025/11/12.
+//
+
+#include "DirWalker.h"
+
+#include <algorithm>
+#include <chrono>
+
+
+namespace {
+    RE2::Options ignoreRegexOptions() {
+        RE2::Options opt;
+        opt.set_log_errors(false);
+        return opt;
+    }
+
+    // 无论忽略规则如何都不进入的文件夹
+    bool skipDir(const std::string& name) {
+        return name == ".git" || name == "node_modules";
+    }
+
+    bool isIgnoreFile(const std::string& name) {
+        return name == ".gitignore" || name == ".mdtoolignore";
+    }
+
+    struct Entry {
+        fs::path path;
+        std::string name;
+        bool isDir;
+    };
+
+    // 某一层目录的忽略规则，prefixLen 为该目录相对扫描根目录的路径长度
+    struct RuleFrame {
+        size_t prefixLen;
+        std::unique_ptr<IgnoreRules> rules;
+    };
+
+    // 由内向外查找规则，更深层的忽略文件优先；rel 为相对扫描根目录的路径
+    bool ignoredBy(const std::vector<RuleFrame>& frames, const std::string_view rel, const bool isDir) {
+        for (auto frame = frames.rbegin(); frame != frames.rend(); ++frame) {
+            if (const auto r = frame->rules->match(rel.substr(frame->prefixLen), isDir)) {
+                return *r;
+            }
+        }
+        return false;
+    }
+
+    // 逐层载入 root 到 rel 之间各层的忽略文件(不含 rel 本身)，并检查路径上的每一层
+    // rel 为相对 root 的路径(以 / 分隔)，isDir 表示 rel 本身是文件夹；返回 rel 是否会被 walk(root) 跳过
+    bool loadPath(const fs::path& root, const std::string& rel, const bool isDir, std::vector<RuleFrame>& frames) {
+        size_t start = 0;
+        while (true) {
+            if (auto rules = IgnoreRules::load(root / fs::path(rel.substr(0, start)))) {
+                frames.push_back({start, std::move(rules)});
+            }
+            const size_t slash = rel.find('/', start);
+            const bool last = slash == std::string::npos;
+            const bool dir = !last || isDir;
+            const std::string_view child = std::string_view(rel).substr(0, last ? rel.size() : slash);
+            if (dir && skipDir(std::string(child.substr(start)))) {
+                return true;
+            }
+            if (ignoredBy(frames, child, dir)) {
+                return true;
+            }
+            if (last) {
+                return false;
+            }
+            start = slash + 1;
+        }
+    }
+
+    // root 之下的路径相对 root 的部分，不在 root 之下时返回空
+    std::string relativeTo(const fs::path& root, const fs::path& path) {
+        std::string rel = path.lexically_normal().lexically_relative(root.lexically_normal()).generic_string();
+        if (rel == "." || rel.starts_with("..")) {
+            rel.clear();
+        }
+        while (rel.ends_with('/')) {
+            rel.pop_back();
+        }
+        return rel;
+    }
+
+    class Walk {
+    public:
+        Walk(DirWalker::Result& rt, const DirWalker::FileCallback& onFile, const DirWalker::FileCallback& onDir,
+             const double timeoutSeconds)
+            : rt(rt), onFile(onFile), onDir(onDir), hasDeadline(timeoutSeconds > 0) {
+            if (hasDeadline) {
+                deadline = std::chrono::steady_clock::now() +
+                           std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double>(timeoutSeconds));
+            }
+        }
+
+        // 从 base 之下的 rel 开始扫描时，先载入 base 到 rel 之间的忽略规则；rel 本身被忽略时返回 false
+        bool enter(const fs::path& base, const std::string& rel) {
+            return !loadPath(base, rel, true, frames);
+        }
+
+        void dir(const fs::path& path, const std::string& rel) {
+            if (onDir && !call(onDir, path)) {
+                stopped = true;
+                return;
+            }
+
+            std::error_code ec;
+            fs::directory_iterator it(path, fs::directory_options::skip_permission_denied, ec);
+            if (ec) {
+                rt.logs.emplace_back(LOG_TYPE::Warn, "无法打开文件夹：" + path.string() + " " + ec.message());
+                return;
+            }
+
+            // 先收集本层条目，忽略文件要对同层的其他条目生效
+            std::vector<Entry> entries;
+            bool hasIgnore = false;
+            for (const fs::directory_iterator end; it != end; it.increment(ec)) {
+                if (ec) {
+                    rt.logs.emplace_back(LOG_TYPE::Warn, "读取文件夹出错：" + path.string() + " " + ec.message());
+                    break;
+                }
+                if ((++rt.entries & 0xFF) == 0 && timeout()) {
+                    return;
+                }
+
+                // 以下类型判断均使用遍历时缓存的 d_type，仅在文件系统不提供时才 stat
+                const auto& e = *it;
+                if (e.is_symlink(ec)) {
+                    continue;
+                }
+                std::string name = e.path().filename().string();
+                const bool isDir = e.is_directory(ec);
+                if (!isDir) {
+                    if (isIgnoreFile(name)) {
+                        hasIgnore = true;
+                        continue;
+                    }
+                    if (!e.is_regular_file(ec) || !DirWalker::isMarkdown(e.path())) {
+                        continue;
+                    }
+                } else if (skipDir(name)) {
+                    continue;
+                }
+                entries.push_back({e.path(), std::move(name), isDir});
+            }
+
+            bool pushed = false;
+            if (hasIgnore) {
+                if (auto rules = IgnoreRules::load(path)) {
+                    frames.push_back({rel.size(), std::move(rules)});
+                    pushed = true;
+                }
+            }
+
+            std::string child;
+            for (auto& [entryPath, name, isDir] : entries) {
+                if (stopped) {
+                    break;
+                }
+                child.assign(rel).append(name);
+                if (ignored(child, isDir)) {
+                    continue;
+                }
+                if (isDir) {
+                    dir(entryPath, child + '/');
+                    continue;
+                }
+                ++rt.files;
+                if (!call(onFile, entryPath)) {
+                    stopped = true;
+                }
+            }
+
+            if (pushed) {
+                frames.pop_back();
+            }
+        }
+
+    private:
+        // 回调阻塞的时间(如等待有界队列腾出空位)不计入扫描时间，只限制遍历本身
+        bool call(const DirWalker::FileCallback& callback, const fs::path& path) {
+            if (!hasDeadline) {
+                return callback(path);
+            }
+            const auto start = std::chrono::steady_clock::now();
+            const bool result = callback(path);
+            deadline += std::chrono::steady_clock::now() - start;
+            return result;
+        }
+
+        bool timeout() {
+            if (hasDeadline && std::chrono::steady_clock::now() > deadline) {
+                rt.timedOut = true;
+                stopped = true;
+            }
+            return stopped;
+        }
+
+        bool ignored(const std::string& rel, const bool isDir) const {
+            return ignoredBy(frames, rel, isDir);
+        }
+
+        DirWalker::Result& rt;
+        const DirWalker::FileCallback& onFile;
+        const DirWalker::FileCallback& onDir;
+        std::vector<RuleFrame> frames;
+        bool hasDeadline;
+        std::chrono::steady_clock::time_point deadline;
+        bool stopped = false;
+    };
+}
+
+
+IgnoreRules::IgnoreRules() : set(ignoreRegexOptions(), RE2::ANCHOR_BOTH) {}
+
+std::unique_ptr<IgnoreRules> IgnoreRules::load(const fs::path& dir) {
+    auto rules = std::make_unique<IgnoreRules>();
+    for (const char* name : {".gitignore", ".mdtoolignore"}) {
+        std::ifstream file(dir / name, std::ios::binary);
+        std::string line;
+        while (file.is_open() && std::getline(file, line)) {
+            rules->add(line);
+        }
+    }
+    if (rules->negated.empty() || !rules->set.Compile()) {
+        return nullptr;
+    }
+    return rules;
+}
+
+bool IgnoreRules::add(const std::string_view line) {
+    bool negate = false;
+    const auto regex = globToRegex(line, negate);
+    if (!regex) {
+        return false;
+    }
+    std::string error;
+    if (set.Add(*regex, &error) < 0) {
+        logs::print("忽略规则无效：" + std::string(line) + " " + error, LOG_TYPE::Warn);
+        return false;
+    }
+    negated.push_back(negate);
+    return true;
+}
+
+std::optional<std::string> IgnoreRules::globToRegex(std::string_view pattern, bool& negate) {
+    // 去除行尾的 \r 与未转义的空格
+    while (!pattern.empty() && (pattern.back() == '\r' ||
+           (pattern.back() == ' ' && (pattern.size() < 2 || pattern[pattern.size() - 2] != '\\')))) {
+        pattern.remove_suffix(1);
+    }
+    if (pattern.empty() || pattern.front() == '#') {
+        return std::nullopt;
+    }
+
+    negate = false;
+    if (pattern.front() == '!') {
+        negate = true;
+        pattern.remove_prefix(1);
+    }
+
+    // 以 / 结尾只匹配文件夹
+    bool dirOnly = false;
+    if (!pattern.empty() && pattern.back() == '/') {
+        dirOnly = true;
+        pattern.remove_suffix(1);
+    }
+    if (pattern.empty()) {
+        return std::nullopt;
+    }
+
+    // 包含 / 的规则相对忽略文件所在目录，否则可以匹配任意层级
+    const bool anchored = pattern.find('/') != std::string_view::npos;
+    if (pattern.front() == '/') {
+        pattern.remove_prefix(1);
+    }
+
+    std::string re = anchored ? "" : "(?:.*/)?";
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        const char c = pattern[i];
+        if (c == '*') {
+            if (pattern.compare(i, 3, "**/") == 0) {
+                re += "(?:.*/)?";
+                i += 2;
+            } else if (pattern.compare(i, 2, "**") == 0) {
+                re += ".*";
+                ++i;
+            } else {
+                re += "[^/]*";
+            }
+        } else if (c == '?') {
+            re += "[^/]";
+        } else if (c == '[') {
+            size_t close = i + 1;
+            if (close < pattern.size() && (pattern[close] == '!' || pattern[close] == '^')) {
+                ++close;
+            }
+            if (close < pattern.size() && pattern[close] == ']') {
+                ++close;
+            }
+            close = pattern.find(']', close);
+            if (close == std::string_view::npos) {
+                re += "\\[";
+                continue;
+            }
+            re += '[';
+            size_t j = i + 1;
+            if (pattern[j] == '!' || pattern[j] == '^') {
+                re += '^';
+                ++j;
+            }
+            for (; j < close; ++j) {
+                if (pattern[j] == '\\' || pattern[j] == '[') {
+                    re += '\\';
+                }
+                re += pattern[j];
+            }
+            re += ']';
+            i = close;
+        } else if (c == '\\' && i + 1 < pattern.size()) {
+            re += RE2::QuoteMeta(pattern.substr(++i, 1));
+        } else {
+            re += RE2::QuoteMeta(std::string_view(&pattern[i], 1));
+        }
+    }
+    re += dirOnly ? "/" : "/?";
+    return re;
+}
+
+std::optional<bool> IgnoreRules::match(const std::string_view rel, const bool isDir) const {
+    std::string text(rel);
+    if (isDir) {
+        text += '/';
+    }
+    std::vector<int> hits;
+    if (!set.Match(text, &hits) || hits.empty()) {
+        return std::nullopt;
+    }
+    // 同一文件中后出现的规则优先
+    const int last = *std::max_element(hits.begin(), hits.end());
+    return !negated[last];
+}
+
+
+bool DirWalker::isMarkdown(const fs::path& path) {
+    std::string ext = path.extension().string();
+    for (char& c : ext) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return ext == ".md" || ext == ".markdown";
+}
+
+bool DirWalker::isIgnored(const fs::path& root, const fs::path& path, const bool isDir) {
+    const std::string rel = relativeTo(root, path);
+    if (rel.empty()) {
+        return false;
+    }
+    // 与 walk 一样逐层载入忽略文件，并检查路径上的每一层文件夹
+    std::vector<RuleFrame> frames;
+    return loadPath(root, rel, isDir, frames);
+}
+
+DirWalker::Result DirWalker::walk(const fs::path& root, const FileCallback& onFile, const FileCallback& onDir) const {
+    return walk(root, root, onFile, onDir);
+}
+
+DirWalker::Result DirWalker::walk(const fs::path& base, const fs::path& root, const FileCallback& onFile,
+                                  const FileCallback& onDir) const {
+    Result rt;
+    Walk walk(rt, onFile, onDir, timeoutSeconds);
+    const std::string rel = relativeTo(base, root);
+    if (rel.empty()) {
+        walk.dir(root, "");
+    } else if (walk.enter(base, rel)) {
+        walk.dir(root, rel + '/');
+    }
+    if (rt.timedOut) {
+        rt.logs.emplace_back(LOG_TYPE::Error,
+            "扫描文件夹超时(" + std::to_string(timeoutSeconds) + " 秒)，仅处理已找到的 " +
+            std::to_string(rt.files) + " 个文档，可用 -t 调整");
+    }
+    return rt;
+}
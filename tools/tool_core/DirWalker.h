@@ -0,0 +1,72 @@
+//
+// Created by zerox on 2025/11/12.
+//
+
+#ifndef MDTOOL2_DIRWALKER_H
+#define MDTOOL2_DIRWALKER_H
+
+#include <functional>
+#include <memory>
+#include <re2/set.h>
+#include "../../global.h"
+
+
+// 单个目录下 .gitignore / .mdtoolignore 的全部规则，编译为一个 RE2::Set
+class IgnoreRules {
+public:
+    // 读取 dir 下的忽略文件，没有有效规则时返回 nullptr
+    static std::unique_ptr<IgnoreRules> load(const fs::path& dir);
+
+    // 将一条 gitignore 规则转换为正则，空行与注释返回 nullopt
+    static std::optional<std::string> globToRegex(std::string_view pattern, bool& negate);
+
+    // rel 为相对规则所在目录的路径(以 / 分隔)
+    // 返回 true 忽略、false 不忽略(! 规则)、nullopt 没有规则匹配
+    std::optional<bool> match(std::string_view rel, bool isDir) const;
+
+    IgnoreRules();
+
+private:
+    bool add(std::string_view line);
+
+    RE2::Set set;
+    std::vector<bool> negated;
+};
+
+
+// 文件夹扫描：依赖 directory_entry 缓存的 d_type 判断类型，不对每个条目 stat
+class DirWalker {
+public:
+    struct Result {
+        size_t files = 0;       // 交给回调的文件数
+        size_t entries = 0;     // 遍历过的条目数
+        bool timedOut = false;
+        std::vector<logs::alog> logs;
+    };
+
+    // 回调返回 false 时停止扫描
+    using FileCallback = std::function<bool(const fs::path&)>;
+
+    // timeoutSeconds <= 0 表示不限制扫描时间；只计算遍历本身，回调中的时间不计入
+    explicit DirWalker(double timeoutSeconds) : timeoutSeconds(timeoutSeconds) {}
+
+    // 扫描 root 下的所有 md 文档，每找到一个立即调用 onFile
+    // onDir 不为空时，每进入一个未被忽略的文件夹(包括 root)先调用 onDir
+    Result walk(const fs::path& root, const FileCallback& onFile, const FileCallback& onDir = nullptr) const;
+
+    // 只扫描 base 之下的 root，结果与 walk(base) 中 root 的部分一致：base 到 root 之间的忽略文件同样生效，
+    // root 本身被忽略时不扫描
+    Result walk(const fs::path& base, const fs::path& root, const FileCallback& onFile,
+                const FileCallback& onDir = nullptr) const;
+
+    static bool isMarkdown(const fs::path& path);
+
+    // path 是否会被 walk(root) 跳过：逐层读取 root 到 path 之间的忽略文件判断，isDir 表示 path 是文件夹
+    static bool isIgnored(const fs::path& root, const fs::path& path, bool isDir = false);
+
+private:
+    double timeoutSeconds;
+};
+
+
+#endif //MDTOOL2_DIRWALKER_H
\ No newline at end of file
@@ -0,0 +1,566 @@
+//
+// Created by zerox on 2025/11/20.
+//
+
+#include "FrontMatter.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+    constexpr std::string_view kBom = "\xEF\xBB\xBF";
+
+    // 去除行尾的换行、空格与制表符
+    std::string_view trimRight(std::string_view s) {
+        while (!s.empty() && (s.back() == '\n' || s.back() == '\r' || s.back() == ' ' || s.back() == '\t')) {
+            s.remove_suffix(1);
+        }
+        return s;
+    }
+
+    std::string_view trim(std::string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+            s.remove_prefix(1);
+        }
+        return trimRight(s);
+    }
+
+    // 下一行的起点，最后一行没有换行时为 text.size()
+    size_t nextLine(const std::string_view text, const size_t pos) {
+        const size_t nl = text.find('\n', pos);
+        return nl == std::string_view::npos ? text.size() : nl + 1;
+    }
+
+    bool isOpening(const std::string_view line) {
+        return trimRight(line) == "---";
+    }
+
+    bool isClosing(const std::string_view line) {
+        const auto s = trimRight(line);
+        return s == "---" || s == "...";
+    }
+
+    // 顶层 "键: 值" 行返回键，valuePos 为冒号之后的偏移；其他行返回空
+    std::string_view keyOf(const std::string_view line, size_t& valuePos) {
+        if (line.empty() || line[0] == ' ' || line[0] == '\t' || line[0] == '#' || line[0] == '-') {
+            return {};
+        }
+        for (size_t i = 0; i < line.size(); ++i) {
+            if (line[i] != ':') {
+                continue;
+            }
+            if (i + 1 < line.size() && line[i + 1] != ' ' && line[i + 1] != '\t' &&
+                line[i + 1] != '\r' && line[i + 1] != '\n') {
+                continue;
+            }
+            valuePos = i + 1;
+            std::string_view key = trimRight(line.substr(0, i));
+            if (key.size() >= 2 && (key.front() == '"' || key.front() == '\'') && key.back() == key.front()) {
+                key = key.substr(1, key.size() - 2);
+            }
+            return key;
+        }
+        return {};
+    }
+
+    // 属于上一个键的后续行：缩进行、空行，以及与键同级的 - 列表项
+    bool isContinuation(const std::string_view line) {
+        return line[0] == ' ' || line[0] == '\t' || line[0] == '\r' || line[0] == '\n' ||
+               (line[0] == '-' && !isOpening(line));
+    }
+
+    // value 以引号开头时返回闭合引号之后的偏移，没有闭合引号时返回 npos
+    // 单引号内 '' 表示一个单引号，双引号内 \ 转义下一个字符
+    size_t quotedEnd(const std::string_view value) {
+        const char quote = value.front();
+        for (size_t i = 1; i < value.size(); ++i) {
+            if (quote == '"' && value[i] == '\\') {
+                ++i;
+            } else if (value[i] == quote) {
+                if (quote == '\'' && i + 1 < value.size() && value[i + 1] == '\'') {
+                    ++i;
+                    continue;
+                }
+                return i + 1;
+            }
+        }
+        return std::string_view::npos;
+    }
+
+    // 单行值：去除行尾注释，引号内的 # 不是注释
+    std::string_view inlineValue(std::string_view value) {
+        value = trim(value);
+        if (value.starts_with('#')) {
+            return {};
+        }
+        if (value.starts_with('"') || value.starts_with('\'')) {
+            const size_t end = quotedEnd(value);
+            return end == std::string_view::npos ? value : value.substr(0, end);
+        }
+        if (const size_t comment = value.find(" #"); comment != std::string_view::npos) {
+            value = trimRight(value.substr(0, comment));
+        }
+        return value;
+    }
+
+    void appendUtf8(std::string& out, const uint32_t cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | cp >> 6);
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xE0 | cp >> 12);
+            out += static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    // 读取 \x 与 \u 之后的 n 位十六进制数，不足时返回 nullopt
+    std::optional<uint32_t> hexOf(const std::string_view s, const size_t pos, const size_t n) {
+        if (pos + n > s.size()) {
+            return std::nullopt;
+        }
+        uint32_t v = 0;
+        for (size_t i = pos; i < pos + n; ++i) {
+            const char c = s[i];
+            const int d = c >= '0' && c <= '9' ? c - '0'
+                        : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                        : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            if (d < 0) {
+                return std::nullopt;
+            }
+            v = v << 4 | static_cast<uint32_t>(d);
+        }
+        return v;
+    }
+
+    // 还原双引号值中的转义，无法识别的转义保留原文
+    std::string unescape(const std::string_view s) {
+        std::string out;
+        out.reserve(s.size());
+        for (size_t i = 0; i < s.size(); ++i) {
+            if (s[i] != '\\' || i + 1 == s.size()) {
+                out += s[i];
+                continue;
+            }
+            const char c = s[++i];
+            switch (c) {
+                case 'n':
+                    out += '\n';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                case 't':
+                    out += '\t';
+                    break;
+                case '0':
+                    out += '\0';
+                    break;
+                case 'a':
+                    out += '\a';
+                    break;
+                case 'b':
+                    out += '\b';
+                    break;
+                case 'e':
+                    out += '\x1B';
+                    break;
+                case 'x':
+                case 'u': {
+                    const size_t n = c == 'x' ? 2 : 4;
+                    if (const auto cp = hexOf(s, i + 1, n)) {
+                        appendUtf8(out, *cp);
+                        i += n;
+                    } else {
+                        out.append(1, '\\').append(1, c);
+                    }
+                    break;
+                }
+                default:
+                    // \\ \" \/ 与 \ 空格等只表示字符本身
+                    out += c;
+            }
+        }
+        return out;
+    }
+
+    bool isControl(const unsigned char c) {
+        return (c < 0x20 && c != '\t') || c == 0x7F;
+    }
+
+    // 以 [ 开头、与之配对的 ] 在末尾(或 { 与 })，按流式集合原样写出，如 tags: [a, b]
+    bool isFlowCollection(const std::string_view v) {
+        if (v.size() < 2 || !((v.front() == '[' && v.back() == ']') || (v.front() == '{' && v.back() == '}'))) {
+            return false;
+        }
+        int depth = 0;
+        for (size_t i = 0; i < v.size(); ++i) {
+            depth += v[i] == '[' || v[i] == '{' ? 1 : v[i] == ']' || v[i] == '}' ? -1 : 0;
+            if (depth == 0) {
+                return i + 1 == v.size();
+            }
+        }
+        return false;
+    }
+
+    // 原样写出时会被读成其他内容的单行值：空值、首尾空白、以 YAML 指示符开头、含 ": " 或 " #"
+    bool needsQuotes(const std::string_view v) {
+        if (v.empty() || v.front() == ' ' || v.front() == '\t' || v.back() == ' ' || v.back() == '\t') {
+            return true;
+        }
+        if (isFlowCollection(v)) {
+            return false;
+        }
+        if (std::string_view("[]{},#&*!|>'\"%@`").find(v.front()) != std::string_view::npos) {
+            return true;
+        }
+        // - ? : 后接空白或单独出现时才是指示符，-1、:x 仍是普通值
+        if ((v.front() == '-' || v.front() == '?' || v.front() == ':') &&
+            (v.size() == 1 || v[1] == ' ' || v[1] == '\t')) {
+            return true;
+        }
+        return v.back() == ':' || v.find(": ") != std::string_view::npos || v.find(":\t") != std::string_view::npos ||
+               v.find(" #") != std::string_view::npos || v.find("\t#") != std::string_view::npos;
+    }
+
+    // 写入 front matter 的值：多行或含控制字符时用双引号转义，需要时用单引号，否则原样
+    std::string scalarOf(const std::string_view value) {
+        std::string out;
+        if (std::any_of(value.begin(), value.end(), [](const char c) {
+            return isControl(static_cast<unsigned char>(c));
+        })) {
+            static constexpr char kHex[] = "0123456789ABCDEF";
+            out.reserve(value.size() + 8);
+            out += '"';
+            for (const char c : value) {
+                switch (c) {
+                    case '\\':
+                        out += "\\\\";
+                        break;
+                    case '"':
+                        out += "\\\"";
+                        break;
+                    case '\n':
+                        out += "\\n";
+                        break;
+                    case '\r':
+                        out += "\\r";
+                        break;
+                    case '\t':
+                        out += "\\t";
+                        break;
+                    default:
+                        if (const auto u = static_cast<unsigned char>(c); isControl(u)) {
+                            out.append("\\x").append(1, kHex[u >> 4]).append(1, kHex[u & 0xF]);
+                        } else {
+                            out += c;
+                        }
+                }
+            }
+            out += '"';
+        } else if (needsQuotes(value)) {
+            out.reserve(value.size() + 4);
+            out += '\'';
+            for (const char c : value) {
+                out.append(c == '\'' ? 2 : 1, c);
+            }
+            out += '\'';
+        } else {
+            out = value;
+        }
+        return out;
+    }
+
+    // 结束行的起点
+    size_t closingLine(const std::string_view header) {
+        size_t pos = nextLine(header, 0);
+        while (pos < header.size()) {
+            const size_t next = nextLine(header, pos);
+            if (isClosing(header.substr(pos, next - pos))) {
+                return pos;
+            }
+            pos = next;
+        }
+        return header.size();
+    }
+
+    std::string_view newlineOf(const std::string_view header) {
+        const size_t nl = header.find('\n');
+        return nl != std::string_view::npos && nl > 0 && header[nl - 1] == '\r' ? "\r\n" : "\n";
+    }
+
+    // 从 from 的 offset 处开始的内容追加到 to 末尾
+    bool copyTail(const fs::path& from, const uintmax_t offset, const fs::path& to) {
+#ifdef __linux__
+        const int in = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+        const int out = ::open(to.c_str(), O_WRONLY | O_CLOEXEC);
+        bool ok = in >= 0 && out >= 0;
+        off_t inOff = static_cast<off_t>(offset);
+        off_t outOff = ok ? ::lseek(out, 0, SEEK_END) : 0;
+        ok = ok && outOff >= 0;
+
+        // 优先在内核中复制(同一文件系统上可能只复制引用)，不支持时回退到 pread/pwrite
+        bool kernelCopy = true;
+        while (ok) {
+            if (kernelCopy) {
+                const ssize_t n = ::copy_file_range(in, &inOff, out, &outOff, 1 << 30, 0);
+                if (n > 0) {
+                    continue;
+                }
+                if (n == 0) {
+                    break;
+                }
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP) {
+                    kernelCopy = false;
+                    continue;
+                }
+                ok = false;
+                break;
+            }
+            char buffer[65536];
+            const ssize_t n = ::pread(in, buffer, sizeof(buffer), inOff);
+            if (n == 0) {
+                break;
+            }
+            if (n < 0) {
+                ok = errno == EINTR;
+                continue;
+            }
+            for (ssize_t done = 0; done < n;) {
+                const ssize_t w = ::pwrite(out, buffer + done, static_cast<size_t>(n - done), outOff);
+                if (w < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (w <= 0) {
+                    ok = false;
+                    break;
+                }
+                done += w;
+                outOff += w;
+            }
+            inOff += n;
+        }
+        if (in >= 0) {
+            ::close(in);
+        }
+        if (out >= 0 && ::close(out) != 0) {
+            ok = false;
+        }
+        return ok;
+#else
+        std::ifstream in(from, std::ios::binary);
+        std::ofstream out(to, std::ios::binary | std::ios::app);
+        if (!in.is_open() || !out.is_open() || !in.seekg(static_cast<std::streamoff>(offset))) {
+            return false;
+        }
+        if (in.peek() != std::char_traits<char>::eof()) {
+            out << in.rdbuf();
+        }
+        return out.good();
+#endif
+    }
+}
+
+
+size_t FrontMatter::locate(const std::string_view data, const bool eof) {
+    const size_t begin = data.starts_with(kBom) ? kBom.size() : 0;
+    size_t pos = nextLine(data, begin);
+    if (!isOpening(data.substr(begin, pos - begin))) {
+        return 0;
+    }
+    while (pos < data.size()) {
+        const size_t next = nextLine(data, pos);
+        // 最后一行没有换行时，只有读到文档末尾才能确定它是完整的结束行
+        if ((next < data.size() || data.back() == '\n' || eof) && isClosing(data.substr(pos, next - pos))) {
+            return next;
+        }
+        pos = next;
+    }
+    return eof ? 0 : std::string_view::npos;
+}
+
+std::optional<FrontMatter::Head> FrontMatter::read(const fs::path& path, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        error = "读取文件失败：" + path.string();
+        return std::nullopt;
+    }
+
+    Head head;
+    size_t end = std::string_view::npos;
+    for (size_t want = kFirstRead; end == std::string_view::npos; want *= 2) {
+        if (want > kMaxSize) {
+            error = "front matter 缺少结束行或超过 " + std::to_string(kMaxSize) + " 字节：" + path.string();
+            return std::nullopt;
+        }
+        const size_t have = head.data.size();
+        head.data.resize(want);
+        file.read(head.data.data() + have, static_cast<std::streamsize>(want - have));
+        head.data.resize(have + static_cast<size_t>(file.gcount()));
+        if (file.bad()) {
+            error = "读取文件失败：" + path.string();
+            return std::nullopt;
+        }
+        head.eof = head.data.size() < want;
+        end = locate(head.data, head.eof);
+    }
+    head.begin = head.data.starts_with(kBom) ? kBom.size() : 0;
+    head.end = end == 0 ? head.begin : end;
+    return head;
+}
+
+std::optional<FrontMatter::Field> FrontMatter::find(const std::string_view header, const std::string_view key) {
+    size_t pos = nextLine(header, 0);
+    while (pos < header.size()) {
+        size_t next = nextLine(header, pos);
+        const std::string_view line = header.substr(pos, next - pos);
+        if (isClosing(line)) {
+            break;
+        }
+        size_t valuePos = 0;
+        if (keyOf(line, valuePos) != key || key.empty()) {
+            pos = next;
+            continue;
+        }
+
+        // 块状值延续到下一个顶层行，末尾的空行不属于这个键
+        Field field{pos, next, inlineValue(line.substr(valuePos))};
+        const size_t blockBegin = next;
+        while (next < header.size()) {
+            const size_t after = nextLine(header, next);
+            const std::string_view cont = header.substr(next, after - next);
+            if (isClosing(cont) || !isContinuation(cont)) {
+                break;
+            }
+            if (!trim(cont).empty()) {
+                field.end = after;
+            }
+            next = after;
+        }
+        if (field.end > blockBegin && (field.value.empty() || field.value[0] == '|' || field.value[0] == '>')) {
+            field.value = trimRight(header.substr(blockBegin, field.end - blockBegin));
+        }
+        return field;
+    }
+    return std::nullopt;
+}
+
+std::string FrontMatter::Field::text() const {
+    if (value.size() < 2 || (value.front() != '"' && value.front() != '\'') || value.back() != value.front()) {
+        return std::string(value);
+    }
+    const std::string_view inner = value.substr(1, value.size() - 2);
+    if (value.front() == '"') {
+        return unescape(inner);
+    }
+    std::string out;
+    out.reserve(inner.size());
+    for (size_t i = 0; i < inner.size(); ++i) {
+        out += inner[i];
+        if (inner[i] == '\'' && i + 1 < inner.size() && inner[i + 1] == '\'') {
+            ++i;
+        }
+    }
+    return out;
+}
+
+std::string FrontMatter::set(const std::string_view header, const std::string_view key,
+                             const std::string_view value) {
+    const std::string_view nl = newlineOf(header);
+    const std::string scalar = scalarOf(value);
+    std::string entry;
+    entry.reserve(key.size() + scalar.size() + 4);
+    entry.append(key).append(": ").append(scalar).append(nl);
+
+    if (header.empty()) {
+        std::string result;
+        result.reserve(entry.size() + 8);
+        result.append("---").append(nl).append(entry).append("---").append(nl);
+        return result;
+    }
+
+    const auto field = find(header, key);
+    const size_t from = field ? field->begin : closingLine(header);
+    const size_t to = field ? field->end : from;
+    std::string result;
+    result.reserve(header.size() + entry.size());
+    result.append(header.substr(0, from)).append(entry).append(header.substr(to));
+    return result;
+}
+
+std::string FrontMatter::remove(const std::string_view header, const std::string_view key) {
+    const auto field = find(header, key);
+    if (!field) {
+        return std::string(header);
+    }
+    std::string result;
+    result.reserve(header.size());
+    result.append(header.substr(0, field->begin)).append(header.substr(field->end));
+    return result;
+}
+
+bool FrontMatter::splice(const fs::path& path, const Head& head, const std::string_view header, std::string& error) {
+    // 长度不变时(如 draft: true 改为 draft: null)只覆盖开头，不复制正文
+    if (header.size() == head.end - head.begin) {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        if (file.is_open() && file.seekp(static_cast<std::streamoff>(head.begin)) &&
+            file.write(header.data(), static_cast<std::streamsize>(header.size())) && file.flush()) {
+            // 缓冲的内容可能在关闭时才写出，关闭失败同样视为保存失败
+            file.close();
+            if (!file.fail()) {
+                return true;
+            }
+        }
+        error = "保存失败：" + path.string();
+        return false;
+    }
+
+    fs::path tmp = path;
+    tmp += ".mdtool.tmp";
+    const auto fail = [&](const std::string& msg) {
+        std::error_code ec;
+        fs::remove(tmp, ec);
+        error = msg;
+        return false;
+    };
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return fail("创建临时文件失败：" + tmp.string());
+        }
+        out.write(head.data.data(), static_cast<std::streamsize>(head.begin));
+        out.write(header.data(), static_cast<std::streamsize>(header.size()));
+        // 整篇已在内存中时直接写出，否则正文从原文件复制
+        if (head.eof) {
+            const std::string_view body = std::string_view(head.data).substr(head.end);
+            out.write(body.data(), static_cast<std::streamsize>(body.size()));
+        }
+        out.close();
+        if (out.fail()) {
+            return fail("写入临时文件失败：" + tmp.string());
+        }
+    }
+    if (!head.eof && !copyTail(path, head.end, tmp)) {
+        return fail("写入临时文件失败：" + tmp.string());
+    }
+
+    // 保留原文件权限后替换
+    std::error_code ec;
+    fs::permissions(tmp, fs::status(path, ec).permissions(), ec);
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        return fail("保存失败：" + path.string() + " " + ec.message());
+    }
+    return true;
+}
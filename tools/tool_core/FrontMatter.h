@@ -0,0 +1,61 @@
+//
+// Created by zerox on 2025/11/20.
+//
+
+#ifndef MDTOOL2_FRONTMATTER_H
+#define MDTOOL2_FRONTMATTER_H
+
+#include "../../global.h"
+
+
+// 文档开头 --- 与 --- 之间的 front matter
+// 只读取文档开头直到结束行的部分，修改时替换这一段，正文原样复制，不经过解码
+class FrontMatter {
+public:
+    static constexpr size_t kFirstRead = 4096;        // 第一次读取的字节数，不够时加倍
+    static constexpr size_t kMaxSize = 1 << 20;       // front matter 最大长度，超过时视为没有结束行
+
+    // 从文档开头读入的内容
+    struct Head {
+        std::string data;   // 读入的字节，可能包含部分正文
+        size_t begin = 0;   // 开始 --- 行的偏移(跳过 utf8 BOM)
+        size_t end = 0;     // 结束 --- 行之后的偏移，与 begin 相同表示没有 front matter
+        bool eof = false;   // data 已包含整个文档
+
+        std::string_view header() const {
+            return std::string_view(data).substr(begin, end - begin);
+        }
+    };
+
+    // 顶层键在 header 中的位置：[begin, end) 为整个条目，包括块状值的后续行
+    struct Field {
+        size_t begin = 0;
+        size_t end = 0;
+        std::string_view value;  // 单行值去除行尾注释，保留引号；块状值为后续行原文
+
+        // 值的内容：单行值去除引号并还原转义，块状值原样返回
+        std::string text() const;
+    };
+
+    // 在 data 开头查找 front matter，返回结束行之后的偏移；eof 表示 data 为整个文档
+    // 没有 front matter 时返回 0，data 中还没有出现结束行时返回 npos
+    static size_t locate(std::string_view data, bool eof);
+
+    // 读取文档开头直到 front matter 结束，失败时返回 nullopt 并写入 error
+    static std::optional<Head> read(const fs::path& path, std::string& error);
+
+    // 查找顶层键，只扫描 header，不分配内存
+    static std::optional<Field> find(std::string_view header, std::string_view key);
+
+    // 设置或删除顶层键，返回新的 header；header 为空时新建，换行符与原 header 一致
+    // 值按需加引号：会被读成其他内容的单行值用单引号，多行或含控制字符的值用双引号转义
+    static std::string set(std::string_view header, std::string_view key, std::string_view value);
+    static std::string remove(std::string_view header, std::string_view key);
+
+    // 用 header 替换 head 中的 front matter 写回 path
+    // 长度不变时原地覆盖，否则写入临时文件：开头为新 header，正文用 copy_file_range 从原文件复制
+    static bool splice(const fs::path& path, const Head& head, std::string_view header, std::string& error);
+};
+
+
+#endif //MDTOOL2_FRONTMATTER_H
@@ -0,0 +1,1030 @@
+//
+// Created by zerox on 2025/11/18.
+//
+
+#include "GitRepo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <zlib.h>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+
+
+namespace {
+    constexpr size_t kHashSize = 20;
+    constexpr int kMaxDeltaDepth = 64;
+
+    enum ObjectType {
+        OBJ_COMMIT = 1,
+        OBJ_TREE = 2,
+        OBJ_BLOB = 3,
+        OBJ_TAG = 4,
+        OBJ_OFS_DELTA = 6,
+        OBJ_REF_DELTA = 7,
+    };
+
+    uint32_t be32(const unsigned char* p) {
+        return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+    }
+
+    uint16_t be16(const unsigned char* p) {
+        return static_cast<uint16_t>(p[0] << 8 | p[1]);
+    }
+
+    int hexValue(const char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // 工作区文件的大小与修改时间，用于与 index 记录比较
+    struct FileStamp {
+        uintmax_t size = 0;
+        uint32_t sec = 0;
+        uint32_t nsec = 0;
+    };
+
+    // Linux 上一次 stat 同时取得大小与纳秒级修改时间，其他平台分两次查询
+    std::optional<FileStamp> statFile(const fs::path& file) {
+#ifdef __linux__
+        struct stat st{};
+        if (::stat(file.c_str(), &st) != 0) {
+            return std::nullopt;
+        }
+        return FileStamp{static_cast<uintmax_t>(st.st_size), static_cast<uint32_t>(st.st_mtim.tv_sec),
+                         static_cast<uint32_t>(st.st_mtim.tv_nsec)};
+#else
+        std::error_code ec;
+        const auto size = fs::file_size(file, ec);
+        if (ec) {
+            return std::nullopt;
+        }
+        const auto mtime = fs::last_write_time(file, ec);
+        if (ec) {
+            return std::nullopt;
+        }
+        const auto since = std::chrono::file_clock::to_sys(mtime).time_since_epoch();
+        const auto sec = std::chrono::duration_cast<std::chrono::seconds>(since);
+        const auto nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(since - sec);
+        return FileStamp{size, static_cast<uint32_t>(sec.count()), static_cast<uint32_t>(nsec.count())};
+#endif
+    }
+
+    bool isHex(const std::string_view s) {
+        return std::all_of(s.begin(), s.end(), [](const char c) { return hexValue(c) >= 0; });
+    }
+
+    std::optional<GitRepo::Hash> parseHex(const std::string_view s) {
+        if (s.size() < kHashSize * 2) {
+            return std::nullopt;
+        }
+        GitRepo::Hash h{};
+        for (size_t i = 0; i < kHashSize; ++i) {
+            const int hi = hexValue(s[2 * i]);
+            const int lo = hexValue(s[2 * i + 1]);
+            if (hi < 0 || lo < 0) {
+                return std::nullopt;
+            }
+            h[i] = static_cast<unsigned char>(hi << 4 | lo);
+        }
+        return h;
+    }
+
+    std::string toHex(const GitRepo::Hash& h) {
+        static constexpr char digits[] = "0123456789abcdef";
+        std::string s(kHashSize * 2, '0');
+        for (size_t i = 0; i < kHashSize; ++i) {
+            s[2 * i] = digits[h[i] >> 4];
+            s[2 * i + 1] = digits[h[i] & 0xF];
+        }
+        return s;
+    }
+
+    std::optional<std::string> readAll(const fs::path& path) {
+        std::error_code ec;
+        if (!fs::is_regular_file(path, ec)) {
+            return std::nullopt;
+        }
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return std::nullopt;
+        }
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    std::string_view trim(std::string_view s) {
+        while (!s.empty() && (s.back() == '\n' || s.back() == '\r' || s.back() == ' ')) {
+            s.remove_suffix(1);
+        }
+        while (!s.empty() && s.front() == ' ') {
+            s.remove_prefix(1);
+        }
+        return s;
+    }
+
+    // 与 DirWalker::isMarkdown 相同的判断，直接作用于 index 中的路径字符串
+    bool isMarkdownPath(const std::string_view path) {
+        const auto dot = path.rfind('.');
+        if (dot == std::string_view::npos || path.find('/', dot) != std::string_view::npos) {
+            return false;
+        }
+        std::string ext(path.substr(dot));
+        for (char& c : ext) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return ext == ".md" || ext == ".markdown";
+    }
+
+    // 从 in 的当前位置解压，直到 zlib 流结束；expected 为解压后的大小
+    std::optional<std::string> inflateStream(std::istream& in, const size_t expected) {
+        std::string out(expected, '\0');
+        z_stream zs{};
+        if (inflateInit(&zs) != Z_OK) {
+            return std::nullopt;
+        }
+        char chunk[16384];
+        zs.next_out = reinterpret_cast<Bytef*>(out.data());
+        zs.avail_out = static_cast<uInt>(out.size());
+        int ret = Z_OK;
+        while (ret != Z_STREAM_END) {
+            if (zs.avail_in == 0) {
+                in.read(chunk, sizeof(chunk));
+                const auto got = in.gcount();
+                if (got <= 0) {
+                    break;
+                }
+                zs.next_in = reinterpret_cast<Bytef*>(chunk);
+                zs.avail_in = static_cast<uInt>(got);
+            }
+            // 输出缓冲区已满但流未结束时说明大小不符，借一个临时字节让 zlib 报告结束
+            unsigned char spare;
+            if (zs.avail_out == 0) {
+                zs.next_out = &spare;
+                zs.avail_out = 1;
+                ret = inflate(&zs, Z_NO_FLUSH);
+                if (ret != Z_STREAM_END || zs.avail_out == 0) {
+                    ret = Z_DATA_ERROR;
+                    break;
+                }
+                continue;
+            }
+            ret = inflate(&zs, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END) {
+                break;
+            }
+        }
+        const bool ok = ret == Z_STREAM_END && zs.total_out == expected;
+        inflateEnd(&zs);
+        if (!ok) {
+            return std::nullopt;
+        }
+        return out;
+    }
+
+    // 整段解压，用于松散对象(解压后大小未知)
+    std::optional<std::string> inflateAll(const std::string_view data) {
+        z_stream zs{};
+        if (inflateInit(&zs) != Z_OK) {
+            return std::nullopt;
+        }
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        zs.avail_in = static_cast<uInt>(data.size());
+        std::string out;
+        int ret = Z_OK;
+        while (ret == Z_OK) {
+            const size_t used = out.size();
+            out.resize(std::max<size_t>(used * 2, 4096));
+            zs.next_out = reinterpret_cast<Bytef*>(out.data() + used);
+            zs.avail_out = static_cast<uInt>(out.size() - used);
+            ret = inflate(&zs, Z_NO_FLUSH);
+            out.resize(zs.total_out);
+        }
+        inflateEnd(&zs);
+        if (ret != Z_STREAM_END) {
+            return std::nullopt;
+        }
+        return out;
+    }
+
+    // delta 中的变长整数：低位在前，每字节 7 位，超过 64 位视为数据损坏
+    bool deltaSize(std::string_view& d, size_t& value) {
+        value = 0;
+        unsigned shift = 0;
+        while (!d.empty() && shift < 64) {
+            const auto c = static_cast<unsigned char>(d.front());
+            d.remove_prefix(1);
+            value |= static_cast<size_t>(c & 0x7F) << shift;
+            shift += 7;
+            if (!(c & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::optional<std::string> applyDelta(const std::string& base, std::string_view d) {
+        size_t baseSize = 0, resultSize = 0;
+        if (!deltaSize(d, baseSize) || !deltaSize(d, resultSize) || baseSize != base.size()) {
+            return std::nullopt;
+        }
+        // resultSize 来自对象数据，损坏时可能极大：预留空间不超过 base 与 delta 之和，写出时再逐步检查
+        std::string out;
+        out.reserve(std::min(resultSize, base.size() + d.size()));
+        while (!d.empty()) {
+            const auto op = static_cast<unsigned char>(d.front());
+            d.remove_prefix(1);
+            if (op & 0x80) {
+                // 从 base 复制：offset 与 size 各字节是否存在由 op 的低 7 位指示
+                size_t offset = 0, size = 0;
+                for (int i = 0; i < 4; ++i) {
+                    if (op & (1 << i)) {
+                        if (d.empty()) return std::nullopt;
+                        offset |= static_cast<size_t>(static_cast<unsigned char>(d.front())) << (8 * i);
+                        d.remove_prefix(1);
+                    }
+                }
+                for (int i = 0; i < 3; ++i) {
+                    if (op & (0x10 << i)) {
+                        if (d.empty()) return std::nullopt;
+                        size |= static_cast<size_t>(static_cast<unsigned char>(d.front())) << (8 * i);
+                        d.remove_prefix(1);
+                    }
+                }
+                if (size == 0) {
+                    size = 0x10000;
+                }
+                if (offset > base.size() || size > base.size() - offset || size > resultSize - out.size()) {
+                    return std::nullopt;
+                }
+                out.append(base, offset, size);
+            } else if (op != 0) {
+                // 插入 op 个字节的新内容
+                if (d.size() < op || op > resultSize - out.size()) {
+                    return std::nullopt;
+                }
+                out.append(d.substr(0, op));
+                d.remove_prefix(op);
+            } else {
+                return std::nullopt;
+            }
+        }
+        if (out.size() != resultSize) {
+            return std::nullopt;
+        }
+        return out;
+    }
+}
+
+
+// 一个 pack 及其 .idx：只读取 fanout 表，查找时按需 seek 二分，不把整个 idx 读入内存
+struct GitRepo::Pack {
+    std::ifstream idx;
+    std::ifstream pack;
+    std::array<uint32_t, 256> fanout{};
+
+    bool open(const fs::path& idxPath) {
+        idx.open(idxPath, std::ios::binary);
+        fs::path packPath = idxPath;
+        packPath.replace_extension(".pack");
+        pack.open(packPath, std::ios::binary);
+        if (!idx.is_open() || !pack.is_open()) {
+            return false;
+        }
+        // 只支持 v2 索引：\377tOc + 版本 2 + 256 项 fanout
+        unsigned char header[8 + 256 * 4];
+        if (!idx.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+            be32(header) != 0xFF744F63 || be32(header + 4) != 2) {
+            return false;
+        }
+        for (size_t i = 0; i < 256; ++i) {
+            fanout[i] = be32(header + 8 + i * 4);
+        }
+        return true;
+    }
+
+    uint32_t count() const {
+        return fanout[255];
+    }
+
+    bool hashAt(const uint32_t i, Hash& h) {
+        idx.clear();
+        idx.seekg(8 + 256 * 4 + static_cast<std::streamoff>(i) * kHashSize);
+        return static_cast<bool>(idx.read(reinterpret_cast<char*>(h.data()), kHashSize));
+    }
+
+    // 返回第一个不小于 key 前 len 字节的位置
+    uint32_t lowerBound(const Hash& key, const size_t len) {
+        uint32_t lo = key[0] ? fanout[key[0] - 1] : 0;
+        uint32_t hi = fanout[key[0]];
+        Hash h{};
+        while (lo < hi) {
+            const uint32_t mid = lo + (hi - lo) / 2;
+            if (!hashAt(mid, h)) {
+                return count();
+            }
+            if (std::memcmp(h.data(), key.data(), len) < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    std::optional<uint64_t> offsetOf(const Hash& key) {
+        const uint32_t i = lowerBound(key, kHashSize);
+        Hash h{};
+        if (i >= count() || !hashAt(i, h) || h != key) {
+            return std::nullopt;
+        }
+        const std::streamoff offsets = 8 + 256 * 4 + static_cast<std::streamoff>(count()) * (kHashSize + 4);
+        unsigned char buf[8];
+        idx.clear();
+        idx.seekg(offsets + static_cast<std::streamoff>(i) * 4);
+        if (!idx.read(reinterpret_cast<char*>(buf), 4)) {
+            return std::nullopt;
+        }
+        const uint32_t small = be32(buf);
+        if (!(small & 0x80000000u)) {
+            return small;
+        }
+        // 最高位为 1 时指向 64 位偏移表
+        idx.seekg(offsets + static_cast<std::streamoff>(count()) * 4 +
+                  static_cast<std::streamoff>(small & 0x7FFFFFFFu) * 8);
+        if (!idx.read(reinterpret_cast<char*>(buf), 8)) {
+            return std::nullopt;
+        }
+        return uint64_t(be32(buf)) << 32 | be32(buf + 4);
+    }
+};
+
+
+GitRepo::GitRepo(fs::path workDir, fs::path gitDir, fs::path commonDir)
+    : workDir(std::move(workDir)), gitDir(std::move(gitDir)), commonDir(std::move(commonDir)) {}
+
+GitRepo::~GitRepo() = default;
+
+std::unique_ptr<GitRepo> GitRepo::discover(const fs::path& start) {
+    std::error_code ec;
+    fs::path dir = fs::absolute(start, ec);
+    if (ec) {
+        return nullptr;
+    }
+    if (!fs::is_directory(dir, ec)) {
+        dir = dir.parent_path();
+    }
+
+    for (; !dir.empty(); dir = dir.parent_path()) {
+        const fs::path dotGit = dir / ".git";
+        fs::path gitDir;
+        if (fs::is_directory(dotGit, ec)) {
+            gitDir = dotGit;
+        } else if (fs::is_regular_file(dotGit, ec)) {
+            // 链接工作区与子模块：.git 文件内容为 "gitdir: <路径>"
+            const auto content = readAll(dotGit);
+            if (!content || !content->starts_with("gitdir:")) {
+                return nullptr;
+            }
+            gitDir = fs::path(std::string(trim(std::string_view(*content).substr(7))));
+            if (gitDir.is_relative()) {
+                gitDir = dir / gitDir;
+            }
+        }
+        if (!gitDir.empty()) {
+            fs::path commonDir = gitDir;
+            if (const auto common = readAll(gitDir / "commondir")) {
+                commonDir = fs::path(std::string(trim(*common)));
+                if (commonDir.is_relative()) {
+                    commonDir = gitDir / commonDir;
+                }
+            }
+            return std::unique_ptr<GitRepo>(new GitRepo(dir, gitDir, commonDir));
+        }
+        if (dir == dir.root_path()) {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+bool GitRepo::loadIndex(std::vector<logs::alog>& logs) {
+    const auto content = readAll(gitDir / "index");
+    if (!content) {
+        // 空仓库没有 index，视为没有任何已跟踪文件
+        return true;
+    }
+    const auto* base = reinterpret_cast<const unsigned char*>(content->data());
+    const size_t size = content->size();
+    if (size < 12 + kHashSize || std::memcmp(base, "DIRC", 4) != 0) {
+        logs.emplace_back(LOG_TYPE::Error, "无法识别的 git index 格式");
+        return false;
+    }
+    const uint32_t version = be32(base + 4);
+    const uint32_t count = be32(base + 8);
+    if (version < 2 || version > 4) {
+        logs.emplace_back(LOG_TYPE::Error, "不支持的 git index 版本：" + std::to_string(version));
+        return false;
+    }
+
+    const size_t end = size - kHashSize;
+    size_t pos = 12;
+    entries.reserve(count);
+    std::string previous;
+    for (uint32_t i = 0; i < count; ++i) {
+        // 固定部分：ctime mtime dev ino mode uid gid size 各 4 字节，哈希 20 字节，flags 2 字节
+        constexpr size_t kFixed = 40 + kHashSize + 2;
+        if (pos + kFixed > end) {
+            logs.emplace_back(LOG_TYPE::Error, "git index 数据不完整");
+            return false;
+        }
+        const unsigned char* p = base + pos;
+        if ((be32(p + 24) & 0170000) == 0040000) {
+            // sparse index 中代表整个目录的条目
+            logs.emplace_back(LOG_TYPE::Error, "不支持 sparse index，可执行 git sparse-checkout init --no-sparse-index 后重试");
+            return false;
+        }
+        IndexEntry e;
+        e.mtimeSec = be32(p + 8);
+        e.mtimeNsec = be32(p + 12);
+        e.size = be32(p + 36);
+        std::memcpy(e.hash.data(), p + 40, kHashSize);
+        const uint16_t flags = be16(p + 60);
+        size_t name = pos + kFixed;
+        if (flags & 0x4000) {
+            if (version < 3 || name + 2 > end) {
+                logs.emplace_back(LOG_TYPE::Error, "git index 数据不完整");
+                return false;
+            }
+            e.skipWorktree = be16(base + name) & 0x4000;
+            name += 2;
+        }
+        const bool conflicted = (flags >> 12 & 0x3) != 0;
+
+        if (version == 4) {
+            // 路径前缀压缩：先去掉上一条路径末尾 n 个字节，再接上本条的后缀
+            // n 为变长整数，读取每个字节前检查是否越过 end；n 超过上一条路径的长度即为损坏，不会溢出
+            if (name >= end) {
+                logs.emplace_back(LOG_TYPE::Error, "git index 数据不完整");
+                return false;
+            }
+            size_t strip = base[name] & 0x7F;
+            while (base[name] & 0x80) {
+                if (++name >= end || strip > previous.size()) {
+                    logs.emplace_back(LOG_TYPE::Error, "git index 数据不完整");
+                    return false;
+                }
+                strip = ((strip + 1) << 7) | (base[name] & 0x7F);
+            }
+            ++name;
+            const auto* nul = name < end
+                ? static_cast<const unsigned char*>(std::memchr(base + name, 0, end - name)) : nullptr;
+            if (!nul || strip > previous.size()) {
+                logs.emplace_back(LOG_TYPE::Error, "git index 数据不完整");
+                return false;
+            }
+            previous.resize(previous.size() - strip);
+            previous.append(reinterpret_cast<const char*>(base + name), nul - (base + name));
+            e.path = previous;
+            pos = static_cast<size_t>(nul - base) + 1;
+        } else {
+            const auto* nul = static_cast<const unsigned char*>(std::memchr(base + name, 0, end - name));
+            if (!nul) {
+                logs.emplace_back(LOG_TYPE::Error, "git index 数据不完整");
+                return false;
+            }
+            e.path.assign(reinterpret_cast<const char*>(base + name), nul - (base + name));
+            // 条目按 8 字节对齐，路径后至少一个 NUL
+            pos += (name - pos + e.path.size() + 8) & ~size_t{7};
+        }
+
+        // 冲突中的文件每个阶段各有一条，只保留一条并清空哈希使其总被视为修改
+        if (conflicted) {
+            if (!entries.empty() && entries.back().path == e.path) {
+                continue;
+            }
+            e.hash = Hash{};
+        }
+        entries.push_back(std::move(e));
+    }
+
+    // 扩展：只使用 TREE(cache tree)；签名首字母大写的扩展是可选的，可以跳过
+    // 小写签名表示不理解就无法正确读取 index，如 link(split index) 与 sdir(sparse index)
+    while (pos + 8 <= end) {
+        const std::string signature(content->data() + pos, 4);
+        const uint32_t extSize = be32(base + pos + 4);
+        if (pos + 8 + extSize > end) {
+            logs.emplace_back(LOG_TYPE::Error, "git index 数据不完整");
+            return false;
+        }
+        if (signature == "link") {
+            logs.emplace_back(LOG_TYPE::Error, "不支持 split index，可执行 git update-index --no-split-index 后重试");
+            return false;
+        }
+        if (signature == "sdir") {
+            logs.emplace_back(LOG_TYPE::Error, "不支持 sparse index，可执行 git sparse-checkout init --no-sparse-index 后重试");
+            return false;
+        }
+        if (signature[0] < 'A' || signature[0] > 'Z') {
+            logs.emplace_back(LOG_TYPE::Error, "不支持的 git index 扩展：" + signature);
+            return false;
+        }
+        if (signature == "TREE") {
+            std::string_view data(content->data() + pos + 8, extSize);
+            parseCacheTree(data, "");
+        }
+        pos += 8 + extSize;
+    }
+    return true;
+}
+
+void GitRepo::parseCacheTree(std::string_view& data, const std::string& prefix) {
+    // 每项：路径 NUL 条目数 空格 子树数 换行 [哈希]，条目数为 -1 表示已失效
+    const auto nul = data.find('\0');
+    const auto space = data.find(' ', nul);
+    const auto newline = data.find('\n', space);
+    if (nul == std::string_view::npos || space == std::string_view::npos || newline == std::string_view::npos) {
+        data = {};
+        return;
+    }
+    const std::string_view name = data.substr(0, nul);
+    const bool valid = data[nul + 1] != '-';
+    const int subtrees = std::atoi(std::string(data.substr(space + 1, newline - space - 1)).c_str());
+    data.remove_prefix(newline + 1);
+
+    const std::string key = name.empty() ? prefix : prefix + std::string(name) + '/';
+    if (valid) {
+        if (data.size() < kHashSize) {
+            data = {};
+            return;
+        }
+        Hash h{};
+        std::memcpy(h.data(), data.data(), kHashSize);
+        cacheTree[key] = h;
+        data.remove_prefix(kHashSize);
+    }
+    for (int i = 0; i < subtrees && !data.empty(); ++i) {
+        parseCacheTree(data, key);
+    }
+}
+
+std::optional<GitRepo::Hash> GitRepo::readRef(const std::string& name, const int depth) const {
+    if (depth > 5) {
+        return std::nullopt;
+    }
+    for (const auto& dir : {gitDir, commonDir}) {
+        if (const auto content = readAll(dir / name)) {
+            const std::string_view value = trim(*content);
+            if (value.starts_with("ref:")) {
+                return readRef(std::string(trim(value.substr(4))), depth + 1);
+            }
+            return parseHex(value);
+        }
+        if (gitDir == commonDir) {
+            break;
+        }
+    }
+
+    // packed-refs 每行 "<哈希> <引用名>"，^ 开头的行是上一个标签剥离后的提交
+    if (const auto packed = readAll(commonDir / "packed-refs")) {
+        std::string_view rest = *packed;
+        while (!rest.empty()) {
+            const auto eol = rest.find('\n');
+            const std::string_view line = trim(rest.substr(0, eol));
+            rest = eol == std::string_view::npos ? std::string_view{} : rest.substr(eol + 1);
+            if (line.size() > kHashSize * 2 + 1 && line[kHashSize * 2] == ' ' &&
+                line.substr(kHashSize * 2 + 1) == name) {
+                return parseHex(line);
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<GitRepo::Hash> GitRepo::findAbbrev(const std::string_view hex, std::string& error) const {
+    std::optional<Hash> found;
+    bool ambiguous = false;
+    const auto accept = [&](const Hash& h) {
+        if (found && *found != h) {
+            ambiguous = true;
+        }
+        found = h;
+    };
+
+    // 松散对象：objects/<前两位>/<其余>
+    std::error_code ec;
+    const std::string head(hex.substr(0, 2));
+    for (fs::directory_iterator it(commonDir / "objects" / head, ec), end; !ec && it != end; it.increment(ec)) {
+        const std::string rest = it->path().filename().string();
+        if (rest.size() == kHashSize * 2 - 2 && std::string_view(rest).starts_with(hex.substr(2))) {
+            if (const auto h = parseHex(head + rest)) {
+                accept(*h);
+            }
+        }
+    }
+
+    // pack：按完整字节的前缀二分定位，再逐项检查奇数位的半字节
+    Hash key{};
+    for (size_t i = 0; i < hex.size(); ++i) {
+        const int v = hexValue(hex[i]);
+        key[i / 2] |= static_cast<unsigned char>(i % 2 ? v : v << 4);
+    }
+    const size_t bytes = hex.size() / 2;
+    loadPacks();
+    for (const auto& pack : packs) {
+        Hash h{};
+        for (uint32_t i = pack->lowerBound(key, bytes);
+             i < pack->count() && pack->hashAt(i, h) && std::memcmp(h.data(), key.data(), bytes) == 0; ++i) {
+            if (std::string_view(toHex(h)).starts_with(hex)) {
+                accept(h);
+            }
+        }
+    }
+
+    if (ambiguous) {
+        error = "提交缩写有歧义：" + std::string(hex);
+        return std::nullopt;
+    }
+    return found;
+}
+
+std::optional<GitRepo::Hash> GitRepo::peelToCommit(Hash hash) const {
+    for (int i = 0; i < 8; ++i) {
+        const auto obj = readObject(hash);
+        if (!obj) {
+            return std::nullopt;
+        }
+        if (obj->type == OBJ_COMMIT) {
+            return hash;
+        }
+        // 附注标签："object <哈希>" 指向被标记的对象
+        if (obj->type != OBJ_TAG || !obj->data.starts_with("object ")) {
+            return std::nullopt;
+        }
+        const auto next = parseHex(std::string_view(obj->data).substr(7));
+        if (!next) {
+            return std::nullopt;
+        }
+        hash = *next;
+    }
+    return std::nullopt;
+}
+
+std::optional<GitRepo::Hash> GitRepo::parent(const Hash& commit, const unsigned n) const {
+    const auto obj = readObject(commit);
+    if (!obj || obj->type != OBJ_COMMIT) {
+        return std::nullopt;
+    }
+    std::string_view rest = obj->data;
+    unsigned index = 0;
+    while (!rest.empty() && rest.front() != '\n') {
+        const auto eol = rest.find('\n');
+        const std::string_view line = rest.substr(0, eol);
+        if (line.starts_with("parent ") && ++index == n) {
+            return parseHex(line.substr(7));
+        }
+        rest = eol == std::string_view::npos ? std::string_view{} : rest.substr(eol + 1);
+    }
+    return std::nullopt;
+}
+
+std::optional<GitRepo::Hash> GitRepo::treeOf(const Hash& commit) const {
+    const auto obj = readObject(commit);
+    if (!obj || obj->type != OBJ_COMMIT || !obj->data.starts_with("tree ")) {
+        return std::nullopt;
+    }
+    return parseHex(std::string_view(obj->data).substr(5));
+}
+
+std::optional<GitRepo::Hash> GitRepo::resolve(const std::string& rev, std::string& error) const {
+    // 基础部分与 ~N、^N 后缀分开处理
+    const auto cut = rev.find_first_of("~^");
+    std::string name = rev.substr(0, cut);
+    if (name.empty() || name == "@") {
+        name = "HEAD";
+    }
+
+    std::optional<Hash> hash;
+    if (name.size() == kHashSize * 2 && isHex(name)) {
+        hash = parseHex(name);
+    }
+    for (const auto& candidate : {name, "refs/" + name, "refs/tags/" + name, "refs/heads/" + name,
+                                  "refs/remotes/" + name, "refs/remotes/" + name + "/HEAD"}) {
+        if (hash) {
+            break;
+        }
+        hash = readRef(candidate);
+    }
+    if (!hash && name.size() >= 4 && name.size() < kHashSize * 2 && isHex(name)) {
+        hash = findAbbrev(name, error);
+        if (!error.empty()) {
+            return std::nullopt;
+        }
+    }
+    if (!hash || !(hash = peelToCommit(*hash))) {
+        error = "无法解析提交：" + rev;
+        return std::nullopt;
+    }
+
+    std::string_view ops = cut == std::string::npos ? std::string_view{} : std::string_view(rev).substr(cut);
+    while (!ops.empty()) {
+        const char op = ops.front();
+        ops.remove_prefix(1);
+        if (op == '^' && ops.starts_with("{")) {
+            // ^{} 与 ^{commit}：已经剥离到提交，跳过
+            const auto close = ops.find('}');
+            if (close == std::string_view::npos) {
+                error = "无法解析提交：" + rev;
+                return std::nullopt;
+            }
+            ops.remove_prefix(close + 1);
+            continue;
+        }
+        size_t digits = 0;
+        while (digits < ops.size() && std::isdigit(static_cast<unsigned char>(ops[digits]))) {
+            ++digits;
+        }
+        const unsigned n = digits ? static_cast<unsigned>(std::stoul(std::string(ops.substr(0, digits)))) : 1;
+        ops.remove_prefix(digits);
+
+        if (op == '~') {
+            for (unsigned i = 0; i < n && hash; ++i) {
+                hash = parent(*hash, 1);
+            }
+        } else if (n > 0) {
+            hash = parent(*hash, n);
+        }
+        if (!hash) {
+            error = "提交没有对应的父提交：" + rev;
+            return std::nullopt;
+        }
+    }
+    return hash;
+}
+
+void GitRepo::loadPacks() const {
+    if (packsLoaded) {
+        return;
+    }
+    packsLoaded = true;
+    std::error_code ec;
+    for (fs::directory_iterator it(commonDir / "objects" / "pack", ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != ".idx") {
+            continue;
+        }
+        auto pack = std::make_unique<Pack>();
+        if (pack->open(it->path())) {
+            packs.push_back(std::move(pack));
+        }
+    }
+}
+
+std::optional<GitRepo::Object> GitRepo::readLoose(const Hash& hash) const {
+    const std::string hex = toHex(hash);
+    const auto compressed = readAll(commonDir / "objects" / hex.substr(0, 2) / hex.substr(2));
+    if (!compressed) {
+        return std::nullopt;
+    }
+    auto raw = inflateAll(*compressed);
+    if (!raw) {
+        return std::nullopt;
+    }
+    // 头部 "<类型> <大小>\0"
+    const auto nul = raw->find('\0');
+    if (nul == std::string::npos) {
+        return std::nullopt;
+    }
+    const std::string_view type = std::string_view(*raw).substr(0, raw->find(' '));
+    Object obj;
+    obj.type = type == "commit" ? OBJ_COMMIT : type == "tree" ? OBJ_TREE : type == "blob" ? OBJ_BLOB
+             : type == "tag" ? OBJ_TAG : 0;
+    obj.data = raw->substr(nul + 1);
+    return obj;
+}
+
+std::optional<GitRepo::Object> GitRepo::readPacked(Pack& pack, const uint64_t offset, const int depth) const {
+    if (depth > kMaxDeltaDepth) {
+        return std::nullopt;
+    }
+    auto& in = pack.pack;
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(offset));
+
+    // 对象头：类型 3 位，大小为变长整数，低位在前
+    int c = in.get();
+    if (c == EOF) {
+        return std::nullopt;
+    }
+    const int type = c >> 4 & 0x7;
+    size_t size = c & 0xF;
+    unsigned shift = 4;
+    while (c & 0x80) {
+        c = in.get();
+        if (c == EOF || shift >= 64) {
+            return std::nullopt;
+        }
+        size |= static_cast<size_t>(c & 0x7F) << shift;
+        shift += 7;
+    }
+
+    if (type == OBJ_OFS_DELTA || type == OBJ_REF_DELTA) {
+        std::optional<Object> base;
+        std::optional<std::string> delta;
+        if (type == OBJ_OFS_DELTA) {
+            // 基对象位于当前对象之前 distance 字节
+            c = in.get();
+            if (c == EOF) {
+                return std::nullopt;
+            }
+            uint64_t distance = c & 0x7F;
+            while (c & 0x80) {
+                c = in.get();
+                // 距离已超过当前偏移时不必再读，同时避免左移溢出
+                if (c == EOF || distance > offset) {
+                    return std::nullopt;
+                }
+                distance = ((distance + 1) << 7) | (c & 0x7F);
+            }
+            if (distance > offset) {
+                return std::nullopt;
+            }
+            delta = inflateStream(in, size);
+            if (delta) {
+                base = readPacked(pack, offset - distance, depth + 1);
+            }
+        } else {
+            Hash baseHash{};
+            if (!in.read(reinterpret_cast<char*>(baseHash.data()), kHashSize)) {
+                return std::nullopt;
+            }
+            delta = inflateStream(in, size);
+            if (delta) {
+                base = readObject(baseHash, depth + 1);
+            }
+        }
+        if (!base || !delta) {
+            return std::nullopt;
+        }
+        auto data = applyDelta(base->data, *delta);
+        if (!data) {
+            return std::nullopt;
+        }
+        return Object{base->type, std::move(*data)};
+    }
+
+    if (type < OBJ_COMMIT || type > OBJ_TAG) {
+        return std::nullopt;
+    }
+    auto data = inflateStream(in, size);
+    if (!data) {
+        return std::nullopt;
+    }
+    return Object{type, std::move(*data)};
+}
+
+std::optional<GitRepo::Object> GitRepo::readObject(const Hash& hash, const int depth) const {
+    if (auto obj = readLoose(hash)) {
+        return obj;
+    }
+    loadPacks();
+    for (const auto& pack : packs) {
+        if (const auto offset = pack->offsetOf(hash)) {
+            return readPacked(*pack, *offset, depth);
+        }
+    }
+    return std::nullopt;
+}
+
+bool GitRepo::diffTree(const Hash* tree, const std::string& prefix, const size_t lo, const size_t hi,
+                       std::vector<bool>& dirty) const {
+    // cache tree 中记录的子树哈希相同，说明该目录下的 index 与提交完全一致
+    if (tree) {
+        if (const auto it = cacheTree.find(prefix); it != cacheTree.end() && it->second == *tree) {
+            return true;
+        }
+    }
+
+    size_t i = lo;
+    const auto markAdded = [&](const size_t until) {
+        for (; i < until; ++i) {
+            dirty[i] = true;
+        }
+    };
+    if (!tree) {
+        markAdded(hi);
+        return true;
+    }
+
+    const auto obj = readObject(*tree);
+    if (!obj || obj->type != OBJ_TREE) {
+        return false;
+    }
+
+    // 树条目："<模式> <名称>\0<20 字节哈希>"，按 git 的目录排序规则排列，与 index 的路径顺序一致
+    std::string_view data = obj->data;
+    std::string key;
+    while (!data.empty()) {
+        const auto space = data.find(' ');
+        const auto nul = data.find('\0', space);
+        if (space == std::string_view::npos || nul == std::string_view::npos || nul + 1 + kHashSize > data.size()) {
+            return false;
+        }
+        const std::string_view mode = data.substr(0, space);
+        const std::string_view name = data.substr(space + 1, nul - space - 1);
+        Hash hash{};
+        std::memcpy(hash.data(), data.data() + nul + 1, kHashSize);
+        data.remove_prefix(nul + 1 + kHashSize);
+
+        const bool isDir = mode == "40000";
+        key.assign(prefix).append(name);
+        if (isDir) {
+            key += '/';
+        }
+        // 排在该条目之前的 index 条目在提交中不存在，是新增的文件
+        size_t until = i;
+        while (until < hi && entries[until].path < key && !entries[until].path.starts_with(key)) {
+            ++until;
+        }
+        markAdded(until);
+
+        if (isDir) {
+            size_t j = i;
+            while (j < hi && entries[j].path.starts_with(key)) {
+                ++j;
+            }
+            if (j > i && !diffTree(&hash, key, i, j, dirty)) {
+                return false;
+            }
+            i = j;
+        } else if (i < hi && entries[i].path == key) {
+            // 子模块(160000)不处理；其余比较内容哈希，模式变化不算修改
+            if (mode != "160000" && entries[i].hash != hash) {
+                dirty[i] = true;
+            }
+            ++i;
+        }
+    }
+    markAdded(hi);
+    return true;
+}
+
+GitRepo::Result GitRepo::changed(const std::string& rev, const bool withWorktree) {
+    Result rt;
+    if (const auto config = readAll(commonDir / "config");
+        config && config->find("objectformat = sha256") != std::string::npos) {
+        rt.logs.emplace_back(LOG_TYPE::Error, "暂不支持 sha256 格式的 git 仓库");
+        return rt;
+    }
+
+    entries.clear();
+    cacheTree.clear();
+    if (!loadIndex(rt.logs)) {
+        return rt;
+    }
+
+    // 尚无任何提交的仓库中 HEAD 不可解析，此时 index 中的文件全部视为新增
+    std::optional<Hash> tree;
+    std::string error;
+    const auto commit = resolve(rev, error);
+    if (commit) {
+        tree = treeOf(*commit);
+        if (!tree) {
+            rt.logs.emplace_back(LOG_TYPE::Error, "读取提交失败：" + toHex(*commit));
+            return rt;
+        }
+    } else if (!(rev == "HEAD" && !readRef("HEAD"))) {
+        rt.logs.emplace_back(LOG_TYPE::Error, error);
+        return rt;
+    }
+
+    std::vector<bool> dirty(entries.size(), false);
+    if (!diffTree(tree ? &*tree : nullptr, "", 0, entries.size(), dirty)) {
+        rt.logs.emplace_back(LOG_TYPE::Error, "读取 git 对象失败，仓库可能不完整(浅克隆或使用了 alternates)");
+        return rt;
+    }
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& e = entries[i];
+        if (!isMarkdownPath(e.path)) {
+            continue;
+        }
+        if (!dirty[i] && withWorktree && !e.skipWorktree) {
+            // 只对 md 文档 stat，与 index 记录的大小或修改时间不同即视为已修改；已删除的文档跳过
+            const auto stamp = statFile(workDir / fs::path(reinterpret_cast<const char8_t*>(e.path.c_str())));
+            if (!stamp) {
+                continue;
+            }
+            // index 只记录大小的低 32 位；部分平台的 git 不记录纳秒，此时只比较秒
+            dirty[i] = static_cast<uint32_t>(stamp->size) != e.size || stamp->sec != e.mtimeSec ||
+                       (e.mtimeNsec != 0 && stamp->nsec != e.mtimeNsec);
+        }
+        if (dirty[i]) {
+            rt.paths.push_back(e.path);
+        }
+    }
+    rt.success = true;
+    return rt;
+}
@@ -0,0 +1,91 @@
+//
+// Created by zerox on 2025/11/18.
+//
+
+#ifndef MDTOOL2_GITREPO_H
+#define MDTOOL2_GITREPO_H
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include "../../global.h"
+
+
+// 直接读取 .git 中的 index、引用与对象(松散对象和 pack)，不启动 git 进程
+// 只支持 sha1 仓库
+class GitRepo {
+public:
+    using Hash = std::array<unsigned char, 20>;
+
+    struct Result {
+        bool success = false;
+        std::vector<std::string> paths;  // 相对工作区，以 / 分隔，按 index 顺序
+        std::vector<logs::alog> logs;
+    };
+
+    // 从 start 开始向上查找仓库，找不到时返回 nullptr
+    static std::unique_ptr<GitRepo> discover(const fs::path& start);
+
+    const fs::path& workTree() const {
+        return workDir;
+    }
+
+    // rev 树与 index 相比新增或修改的 md 文档
+    // 只比较 cache tree 记录的哈希不一致的子树，开销与改动规模相关而非仓库规模
+    // withWorktree 为 true 时额外包含工作区中 size/mtime 与 index 不一致的 md 文档：
+    // 对提交与 index 之间没有改动的每个已跟踪 md 文档 stat 一次(不读取内容，其他文件与 skip-worktree 条目不 stat)，
+    // 这一部分的开销与已跟踪的 md 文档数成正比；只关心已暂存的改动时用 --staged 可完全跳过
+    Result changed(const std::string& rev, bool withWorktree);
+
+    ~GitRepo();
+
+private:
+    struct IndexEntry {
+        std::string path;
+        Hash hash{};
+        uint32_t size = 0;
+        uint32_t mtimeSec = 0;
+        uint32_t mtimeNsec = 0;
+        bool skipWorktree = false;
+    };
+
+    struct Object {
+        int type = 0;       // 1 commit 2 tree 3 blob 4 tag
+        std::string data;
+    };
+
+    struct Pack;
+
+    GitRepo(fs::path workDir, fs::path gitDir, fs::path commonDir);
+
+    bool loadIndex(std::vector<logs::alog>& logs);
+    void parseCacheTree(std::string_view& data, const std::string& prefix);
+
+    std::optional<Hash> resolve(const std::string& rev, std::string& error) const;
+    std::optional<Hash> readRef(const std::string& name, int depth = 0) const;
+    std::optional<Hash> findAbbrev(std::string_view hex, std::string& error) const;
+    std::optional<Hash> peelToCommit(Hash hash) const;
+    std::optional<Hash> parent(const Hash& commit, unsigned n) const;
+    std::optional<Hash> treeOf(const Hash& commit) const;
+
+    std::optional<Object> readObject(const Hash& hash, int depth = 0) const;
+    std::optional<Object> readLoose(const Hash& hash) const;
+    std::optional<Object> readPacked(Pack& pack, uint64_t offset, int depth) const;
+    void loadPacks() const;
+
+    bool diffTree(const Hash* tree, const std::string& prefix, size_t lo, size_t hi,
+                  std::vector<bool>& dirty) const;
+
+    fs::path workDir;
+    fs::path gitDir;      // HEAD 等工作区私有文件所在目录
+    fs::path commonDir;   // objects、refs 所在目录，非链接工作区时与 gitDir 相同
+
+    std::vector<IndexEntry> entries;
+    std::unordered_map<std::string, Hash> cacheTree;  // 目录前缀(以 / 结尾，根为空串) -> 树哈希
+
+    mutable std::vector<std::unique_ptr<Pack>> packs;
+    mutable bool packsLoaded = false;
+};
+
+
+#endif //MDTOOL2_GITREPO_H
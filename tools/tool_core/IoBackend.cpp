@@ -0,0 +1,613 @@
+//
+// Created by zerox on 2025/11/17.
+//
+
+#include "IoBackend.h"
+
+#include <atomic>
+#include <cassert>
+#include <mutex>
+#include <thread>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define MDTOOL_HAVE_IO_URING
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <linux/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+    // 同步读取整个文件，大于 maxSize 的文件只标记 deferred
+    void readOne(IoFile& file, const uintmax_t maxSize) {
+        std::ifstream stream(file.path, std::ios::binary);
+        if (!stream.is_open()) {
+            file.error = errno ? errno : ENOENT;
+            return;
+        }
+        stream.seekg(0, std::ios::end);
+        const std::streamsize size = stream.tellg();
+        stream.seekg(0, std::ios::beg);
+        if (size < 0) {
+            file.error = EIO;
+            return;
+        }
+        if (static_cast<uintmax_t>(size) > maxSize) {
+            file.deferred = true;
+            return;
+        }
+        file.data.resize(static_cast<size_t>(size));
+        if (!stream.read(file.data.data(), size)) {
+            file.error = EIO;
+        }
+    }
+
+    // 同步截断写回，返回 errno，0 表示成功
+    int writeOne(const IoFile& file) {
+        std::ofstream stream(file.path, std::ios::binary | std::ios::trunc);
+        stream.write(file.data.data(), static_cast<std::streamsize>(file.data.size()));
+        stream.close();
+        return stream.good() ? 0 : errno ? errno : EIO;
+    }
+
+    // 线程池后端：每个线程同步处理一个文件，并发度等于线程数
+    class ThreadPoolBackend final : public IoBackend {
+    public:
+        // 线程数不超过 CPU 核数：读写与处理线程同时运行，更多的线程只会互相争抢
+        explicit ThreadPoolBackend(const unsigned depth)
+            : threads(std::clamp(std::thread::hardware_concurrency(), 1u, std::max(1u, depth))) {}
+
+        const char* name() const override {
+            return "thread";
+        }
+
+        void readFiles(WorkQueue<fs::path>& in, WorkQueue<IoFile>& out, const uintmax_t maxSize) override {
+            run([&] {
+                while (auto path = in.pop()) {
+                    IoFile file{.path = std::move(*path)};
+                    readOne(file, maxSize);
+                    out.push(std::move(file));
+                }
+            });
+        }
+
+        void writeFiles(WorkQueue<IoFile>& in, std::vector<IoFile>& failed) override {
+            std::mutex mutex;
+            run([&] {
+                while (auto file = in.pop()) {
+                    if (const int error = writeOne(*file)) {
+                        std::lock_guard lock(mutex);
+                        failed.push_back({.path = std::move(file->path), .error = error});
+                    }
+                }
+            });
+        }
+
+    private:
+        template <typename F>
+        void run(const F& work) const {
+            std::vector<std::thread> workers;
+            workers.reserve(threads);
+            for (unsigned i = 0; i < threads; ++i) {
+                workers.emplace_back(work);
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+
+        unsigned threads;
+    };
+
+#ifdef MDTOOL_HAVE_IO_URING
+
+    // 不依赖 liburing，直接通过系统调用使用 io_uring
+    class Ring {
+    public:
+        explicit Ring(const unsigned entries) {
+            io_uring_params p{};
+            fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+            if (fd < 0) {
+                return;
+            }
+            // 调用方依赖提交队列至少有 entries 项(内核会向上取整到 2 的幂)
+            if (p.sq_entries < entries) {
+                release();
+                return;
+            }
+
+            sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+            cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+            const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+            if (single) {
+                sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+            }
+            sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                          IORING_OFF_SQ_RING);
+            cqRing = single ? sqRing
+                            : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                   IORING_OFF_CQ_RING);
+            sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+            sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                                                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+            if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqes == MAP_FAILED) {
+                release();
+                return;
+            }
+
+            auto* sq = static_cast<char*>(sqRing);
+            auto* cq = static_cast<char*>(cqRing);
+            sqHead = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+            sqTail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+            sqMask = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+            sqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+            cqHead = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+            cqTail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+            cqMask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+            sqEntries = p.sq_entries;
+            localTail = *sqTail;
+        }
+
+        ~Ring() {
+            release();
+        }
+
+        Ring(const Ring&) = delete;
+        Ring& operator=(const Ring&) = delete;
+
+        bool ok() const {
+            return fd >= 0;
+        }
+
+        // 检查所需的操作码是否都被内核支持
+        bool supports(std::initializer_list<unsigned> ops) const {
+            constexpr unsigned kMaxOps = 256;
+            std::vector<char> buffer(sizeof(io_uring_probe) + kMaxOps * sizeof(io_uring_probe_op), 0);
+            auto* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+            if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, kMaxOps) < 0) {
+                return false;
+            }
+            for (const unsigned op : ops) {
+                if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // 取一个空闲的提交项，队列已满时返回 nullptr
+        io_uring_sqe* sqe() {
+            const unsigned head = std::atomic_ref(*sqHead).load(std::memory_order_acquire);
+            if (localTail - head >= sqEntries) {
+                return nullptr;
+            }
+            const unsigned index = localTail & sqMask;
+            sqArray[index] = index;
+            ++localTail;
+            ++pending;
+            io_uring_sqe* entry = &sqes[index];
+            memset(entry, 0, sizeof(*entry));
+            return entry;
+        }
+
+        // 提交所有新请求并等待至少 waitNr 个完成
+        bool submitAndWait(const unsigned waitNr) {
+            std::atomic_ref(*sqTail).store(localTail, std::memory_order_release);
+#ifdef MDTOOL_URING_FAIL_AT
+            // 测试用：每 N 次提交模拟一次失败，此时已有请求在内核中、新请求尚未提交
+            if (static std::atomic<int> calls = 0; ++calls % MDTOOL_URING_FAIL_AT == 0) {
+                errno = EAGAIN;
+                return false;
+            }
+#endif
+            while (true) {
+                const long ret = syscall(__NR_io_uring_enter, fd, pending, waitNr,
+                                         waitNr ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+                if (ret >= 0) {
+                    pending -= static_cast<unsigned>(ret);
+                    submitted += static_cast<unsigned>(ret);
+                    return true;
+                }
+                if (errno != EINTR) {
+                    return false;
+                }
+            }
+        }
+
+        // 不再提交新请求，等待已交给内核的请求全部完成；之后内核不再访问请求引用的内存
+        // 尚未提交的请求随 Ring 销毁丢弃，内核从未见过它们
+        template <typename F>
+        bool drain(const F& onComplete) {
+            while (submitted > 0) {
+                reap(onComplete);
+                if (submitted == 0) {
+                    break;
+                }
+                const long ret = syscall(__NR_io_uring_enter, fd, 0u, 1u, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template <typename F>
+        void reap(const F& onComplete) {
+            unsigned head = *cqHead;
+            const unsigned tail = std::atomic_ref(*cqTail).load(std::memory_order_acquire);
+            while (head != tail) {
+                const io_uring_cqe cqe = cqes[head & cqMask];
+                ++head;
+                std::atomic_ref(*cqHead).store(head, std::memory_order_release);
+                --submitted;
+                onComplete(cqe);
+            }
+        }
+
+    private:
+        void release() {
+            if (sqes && sqes != MAP_FAILED) {
+                munmap(sqes, sqesSize);
+            }
+            if (cqRing && cqRing != MAP_FAILED && cqRing != sqRing) {
+                munmap(cqRing, cqRingSize);
+            }
+            if (sqRing && sqRing != MAP_FAILED) {
+                munmap(sqRing, sqRingSize);
+            }
+            sqes = nullptr;
+            sqRing = cqRing = nullptr;
+            if (fd >= 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+
+        int fd = -1;
+        void* sqRing = nullptr;
+        void* cqRing = nullptr;
+        io_uring_sqe* sqes = nullptr;
+        size_t sqRingSize = 0;
+        size_t cqRingSize = 0;
+        size_t sqesSize = 0;
+        unsigned* sqHead = nullptr;
+        unsigned* sqTail = nullptr;
+        unsigned* sqArray = nullptr;
+        unsigned sqMask = 0;
+        unsigned* cqHead = nullptr;
+        unsigned* cqTail = nullptr;
+        unsigned cqMask = 0;
+        io_uring_cqe* cqes = nullptr;
+        unsigned sqEntries = 0;
+        unsigned localTail = 0;
+        unsigned pending = 0;     // 已放入提交队列、尚未提交的请求数
+        unsigned submitted = 0;   // 已提交、尚未收到完成事件的请求数
+    };
+
+    // io_uring 后端：单线程驱动，同时保持 depth 个文件的 open/statx/read/write/close 请求
+    class UringBackend final : public IoBackend {
+    public:
+        explicit UringBackend(const unsigned depth) : depth(std::max(1u, depth)) {}
+
+        const char* name() const override {
+            return "uring";
+        }
+
+        static bool available() {
+            const Ring ring(4);
+            return ring.ok() && ring.supports({IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ,
+                                               IORING_OP_WRITE, IORING_OP_CLOSE});
+        }
+
+        void readFiles(WorkQueue<fs::path>& in, WorkQueue<IoFile>& out, const uintmax_t maxSize) override {
+            Ring ring(depth);
+            if (!ring.ok()) {
+                ThreadPoolBackend(depth).readFiles(in, out, maxSize);
+                return;
+            }
+            std::vector<IoFile> retry;
+            const bool ok = drive(ring, in, [&](Slot& slot, fs::path path) {
+                slot.file = IoFile{.path = std::move(path)};
+                slot.path = slot.file.path.string();
+                slot.write = false;
+            }, [&](Slot& slot) {
+                out.push(std::move(slot.file));
+            }, maxSize, retry);
+            if (!ok) {
+                // 提交失败时进行中的文件重新同步读取，剩余的交给线程池
+                for (auto& file : retry) {
+                    IoFile again{.path = std::move(file.path)};
+                    readOne(again, maxSize);
+                    out.push(std::move(again));
+                }
+                ThreadPoolBackend(depth).readFiles(in, out, maxSize);
+            }
+        }
+
+        void writeFiles(WorkQueue<IoFile>& in, std::vector<IoFile>& failed) override {
+            Ring ring(depth);
+            if (!ring.ok()) {
+                ThreadPoolBackend(depth).writeFiles(in, failed);
+                return;
+            }
+            std::vector<IoFile> retry;
+            const bool ok = drive(ring, in, [&](Slot& slot, IoFile file) {
+                slot.file = std::move(file);
+                slot.path = slot.file.path.string();
+                slot.write = true;
+            }, [&](Slot& slot) {
+                if (slot.file.error) {
+                    failed.push_back({.path = std::move(slot.file.path), .error = slot.file.error});
+                }
+            }, 0, retry);
+            if (!ok) {
+                // 进行中的文件可能已被截断或只写了一部分，用原内容重新完整写入
+                for (const auto& file : retry) {
+                    if (const int error = writeOne(file)) {
+                        failed.push_back({.path = file.path, .error = error});
+                    }
+                }
+                ThreadPoolBackend(depth).writeFiles(in, failed);
+            }
+        }
+
+    private:
+        enum class Stage { Open, Statx, Transfer, Close };
+
+        struct Slot {
+            IoFile file;
+            std::string path;
+            struct statx stx{};
+            size_t size = 0;
+            size_t done = 0;
+            int fd = -1;
+            bool write = false;
+            Stage stage = Stage::Open;
+        };
+
+        // 每个文件一个槽位，完成一步后在同一槽位提交下一步；input 为空时等待已提交的请求
+        // 返回 false 表示提交失败：已提交的请求全部完成后，尚未结束的文件(内容不变)放入 retry，
+        // in 中剩余的内容由调用方继续处理
+        template <typename In, typename Start, typename Finish>
+        bool drive(Ring& ring, WorkQueue<In>& in, const Start& start, const Finish& finish, const uintmax_t maxSize,
+                   std::vector<IoFile>& retry) {
+            std::vector<Slot> slots(depth);
+            std::vector<bool> active(depth, false);
+            std::vector<size_t> idle;
+            for (size_t i = depth; i > 0; --i) {
+                idle.push_back(i - 1);
+            }
+
+            size_t inflight = 0;
+            bool inputDone = false;
+            while (true) {
+                while (!idle.empty() && !inputDone) {
+                    auto item = inflight == 0 ? in.pop() : in.tryPop();
+                    if (!item) {
+                        inputDone = inflight == 0 || in.finished();
+                        break;
+                    }
+                    const size_t index = idle.back();
+                    idle.pop_back();
+                    Slot& slot = slots[index];
+                    slot = Slot{};
+                    start(slot, std::move(*item));
+                    active[index] = true;
+                    open(ring, slot, index);
+                    ++inflight;
+                }
+                if (inflight == 0) {
+                    if (inputDone) {
+                        return true;
+                    }
+                    continue;
+                }
+
+                if (!ring.submitAndWait(1)) {
+                    logs::print("io_uring 提交失败，改用线程池：" + std::string(strerror(errno)), LOG_TYPE::Error);
+                    abandon(ring, slots, active, finish, retry);
+                    return false;
+                }
+                ring.reap([&](const io_uring_cqe& cqe) {
+                    const auto index = static_cast<size_t>(cqe.user_data);
+                    if (step(ring, slots[index], index, cqe.res, maxSize)) {
+                        finish(slots[index]);
+                        active[index] = false;
+                        idle.push_back(index);
+                        --inflight;
+                    }
+                });
+            }
+        }
+
+        // 提交失败后放弃 ring：先等待已提交的请求完成，之后内核不再访问槽位中的路径与缓冲区
+        // 已经进入关闭步骤的文件读写已结束，正常结束；其余文件放入 retry 重新处理
+        template <typename Finish>
+        static void abandon(Ring& ring, std::vector<Slot>& slots, std::vector<bool>& active, const Finish& finish,
+                            std::vector<IoFile>& retry) {
+            const bool drained = ring.drain([&](const io_uring_cqe& cqe) {
+                Slot& slot = slots[static_cast<size_t>(cqe.user_data)];
+                if (slot.stage == Stage::Open && cqe.res >= 0) {
+                    slot.fd = cqe.res;
+                } else if (slot.stage == Stage::Close) {
+                    slot.fd = -1;
+                    if (cqe.res < 0 && slot.write && !slot.file.error) {
+                        slot.file.error = -cqe.res;
+                    }
+                }
+            });
+            if (!drained) {
+                // 只有 ring 本身失效时才会发生；内核可能仍在读写槽位的缓冲区，释放它们会破坏内存
+                logs::print("无法等待 io_uring 中的请求完成：" + std::string(strerror(errno)), LOG_TYPE::Error);
+                std::abort();
+            }
+
+            for (size_t i = 0; i < slots.size(); ++i) {
+                if (!active[i]) {
+                    continue;
+                }
+                active[i] = false;
+                Slot& slot = slots[i];
+                // 尚未提交的关闭请求改为同步关闭
+                const int closed = slot.fd >= 0 ? close(slot.fd) : 0;
+                if (slot.stage == Stage::Close) {
+                    if (closed != 0 && slot.write && !slot.file.error) {
+                        slot.file.error = errno;
+                    }
+                    finish(slot);
+                    continue;
+                }
+                if (!slot.write) {
+                    slot.file.data.clear();
+                }
+                slot.file.error = 0;
+                slot.file.deferred = false;
+                retry.push_back(std::move(slot.file));
+            }
+        }
+
+        // 每个槽位同一时刻至多有一个请求，提交队列不少于 depth 项(见 Ring 构造)，因此总能取到提交项
+        static io_uring_sqe* nextSqe(Ring& ring) {
+            io_uring_sqe* sqe = ring.sqe();
+            assert(sqe != nullptr);
+            return sqe;
+        }
+
+        static void open(Ring& ring, Slot& slot, const size_t index) {
+            io_uring_sqe* sqe = nextSqe(ring);
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<uint64_t>(slot.path.c_str());
+            sqe->open_flags = slot.write ? O_WRONLY | O_TRUNC | O_CLOEXEC : O_RDONLY | O_CLOEXEC;
+            sqe->user_data = index;
+            slot.stage = Stage::Open;
+        }
+
+        static void statx(Ring& ring, Slot& slot, const size_t index) {
+            static const char empty[] = "";
+            io_uring_sqe* sqe = nextSqe(ring);
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = slot.fd;
+            sqe->addr = reinterpret_cast<uint64_t>(empty);
+            sqe->statx_flags = AT_EMPTY_PATH;
+            sqe->len = STATX_SIZE;
+            sqe->off = reinterpret_cast<uint64_t>(&slot.stx);
+            sqe->user_data = index;
+            slot.stage = Stage::Statx;
+        }
+
+        static void transfer(Ring& ring, Slot& slot, const size_t index) {
+            constexpr size_t kMaxTransfer = 1u << 30;
+            io_uring_sqe* sqe = nextSqe(ring);
+            sqe->opcode = slot.write ? IORING_OP_WRITE : IORING_OP_READ;
+            sqe->fd = slot.fd;
+            sqe->addr = reinterpret_cast<uint64_t>(slot.file.data.data() + slot.done);
+            sqe->len = static_cast<uint32_t>(std::min(kMaxTransfer, slot.size - slot.done));
+            sqe->off = slot.done;
+            sqe->user_data = index;
+            slot.stage = Stage::Transfer;
+        }
+
+        // 没有打开的文件描述符时直接结束，返回 true 表示该槽位已完成
+        static bool closeFile(Ring& ring, Slot& slot, const size_t index) {
+            if (slot.fd < 0) {
+                return true;
+            }
+            io_uring_sqe* sqe = nextSqe(ring);
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->fd = slot.fd;
+            sqe->user_data = index;
+            slot.stage = Stage::Close;
+            return false;
+        }
+
+        // 处理一个完成事件并提交下一步，返回 true 表示该文件已结束
+        static bool step(Ring& ring, Slot& slot, const size_t index, const int res, const uintmax_t maxSize) {
+            if (res < 0 && slot.stage != Stage::Close) {
+                slot.file.error = -res;
+                if (!slot.write) {
+                    slot.file.data.clear();
+                }
+                return closeFile(ring, slot, index);
+            }
+
+            switch (slot.stage) {
+                case Stage::Open:
+                    slot.fd = res;
+                    if (slot.write) {
+                        slot.size = slot.file.data.size();
+                        if (slot.size == 0) {
+                            return closeFile(ring, slot, index);
+                        }
+                        transfer(ring, slot, index);
+                        return false;
+                    }
+                    statx(ring, slot, index);
+                    return false;
+                case Stage::Statx:
+                    if (slot.stx.stx_size > maxSize) {
+                        slot.file.deferred = true;
+                        return closeFile(ring, slot, index);
+                    }
+                    slot.size = static_cast<size_t>(slot.stx.stx_size);
+                    slot.file.data.resize(slot.size);
+                    if (slot.size == 0) {
+                        return closeFile(ring, slot, index);
+                    }
+                    transfer(ring, slot, index);
+                    return false;
+                case Stage::Transfer:
+                    if (res == 0) {
+                        // 读取时文件被截短，或写入没有进展
+                        if (slot.write) {
+                            slot.file.error = EIO;
+                        } else {
+                            slot.file.data.resize(slot.done);
+                        }
+                        return closeFile(ring, slot, index);
+                    }
+                    slot.done += static_cast<size_t>(res);
+                    if (slot.done < slot.size) {
+                        transfer(ring, slot, index);
+                        return false;
+                    }
+                    return closeFile(ring, slot, index);
+                case Stage::Close:
+                    slot.fd = -1;
+                    if (res < 0 && slot.write && !slot.file.error) {
+                        slot.file.error = -res;
+                    }
+                    return true;
+            }
+            return true;
+        }
+
+        unsigned depth;
+    };
+
+#endif
+}
+
+
+std::unique_ptr<IoBackend> IoBackend::create(const std::string& kind, const unsigned depth) {
+#ifdef MDTOOL_HAVE_IO_URING
+    if (kind != "thread") {
+        static const bool uring = UringBackend::available();
+        if (uring) {
+            return std::make_unique<UringBackend>(depth);
+        }
+        if (kind == "uring") {
+            logs::print("当前系统不支持 io_uring，改用线程池读写", LOG_TYPE::Warn);
+        }
+    }
+#else
+    if (kind == "uring") {
+        logs::print("当前平台不支持 io_uring，改用线程池读写", LOG_TYPE::Warn);
+    }
+#endif
+    return std::make_unique<ThreadPoolBackend>(depth);
+}
@@ -0,0 +1,42 @@
+//
+// Created by zerox on 2025/11/17.
+//
+
+#ifndef MDTOOL2_IOBACKEND_H
+#define MDTOOL2_IOBACKEND_H
+
+#include <memory>
+#include "WorkQueue.h"
+#include "../../global.h"
+
+
+// 批量读写时在线程之间传递的文件
+struct IoFile {
+    fs::path path;
+    std::string data{};
+    int error = 0;          // errno，0 表示成功
+    bool deferred = false;  // 超过大小上限未读取，交给逐文件处理
+};
+
+
+// 文件夹模式的批量读写后端：同时保持多个文件的打开、读取、写入请求
+class IoBackend {
+public:
+    virtual ~IoBackend() = default;
+
+    virtual const char* name() const = 0;
+
+    // 从 in 取路径读取整个文件放入 out，大于 maxSize 的文件只标记 deferred
+    // in 关闭且所有请求完成后返回
+    virtual void readFiles(WorkQueue<fs::path>& in, WorkQueue<IoFile>& out, uintmax_t maxSize) = 0;
+
+    // 从 in 取内容截断写回原文件，失败的文件(不含内容)放入 failed
+    // in 关闭且所有请求完成后返回
+    virtual void writeFiles(WorkQueue<IoFile>& in, std::vector<IoFile>& failed) = 0;
+
+    // kind 为 "uring"、"thread" 或 "auto"；io_uring 不可用时回退到线程池
+    static std::unique_ptr<IoBackend> create(const std::string& kind, unsigned depth);
+};
+
+
+#endif //MDTOOL2_IOBACKEND_H
\ No newline at end of file
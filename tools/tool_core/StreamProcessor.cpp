@@ -0,0 +1,225 @@
+//
+// Created by zerox on 2025/11/14.
+//
+
+#include "StreamProcessor.h"
+
+
+namespace {
+    // 检测只抽样文档开头，开头为纯 ASCII 的 utf8 文档会被报告为 ASCII，同样原样处理
+    bool isUtf8Charset(const std::string& charset) {
+        return charset == "UTF-8" || charset == "UTF8" || charset == "ASCII";
+    }
+
+    // 增量转换 in 中的数据追加到 out，末尾不完整的多字节序列留在 in 中等待下一块
+    bool convert(const iconv_t cd, std::string& in, std::string& out) {
+        char* in_ptr = in.data();
+        size_t in_left = in.size();
+        char temp[65536];
+
+        while (in_left > 0) {
+            char* out_ptr = temp;
+            size_t out_left = sizeof(temp);
+            const size_t res = iconv(cd, &in_ptr, &in_left, &out_ptr, &out_left);
+            out.append(temp, sizeof(temp) - out_left);
+            if (res != static_cast<size_t>(-1)) {
+                break;
+            }
+            if (errno == E2BIG) {
+                continue;
+            }
+            if (errno == EINVAL) {
+                break;
+            }
+            return false;
+        }
+        in.erase(0, in.size() - in_left);
+        return true;
+    }
+
+    // 换行符标准化，行为与 normalize_newlines 一致；块末尾的 \r 需要等下一块才能确定
+    void appendNormalized(std::string& out, const std::string_view in, bool& pendingCR) {
+        for (const char c : in) {
+            if (pendingCR) {
+                pendingCR = false;
+                out.push_back('\n');
+                if (c == '\n') {
+                    continue;
+                }
+            }
+            if (c == '\r') {
+                pendingCR = true;
+            } else {
+                out.push_back(c);
+            }
+        }
+    }
+}
+
+
+FinalFuncReturn StreamProcessor::run(const fs::path& path, const std::string& charset,
+                                     const Splitter& splitter, const WindowFunc& func) {
+    FinalFuncReturn rt;
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, "打开文件失败：" + path.string())};
+        return rt;
+    }
+
+    fs::path tmp = path;
+    tmp += ".mdtool.tmp";
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, "创建临时文件失败：" + tmp.string())};
+        return rt;
+    }
+    const auto fail = [&](const std::string& msg) {
+        out.close();
+        std::error_code ec;
+        fs::remove(tmp, ec);
+        rt.success = false;
+        rt.logs.emplace_back(LOG_TYPE::Error, msg);
+        return rt;
+    };
+
+    // 非 utf8 文档使用 iconv 增量解码与编码
+    const bool passthrough = isUtf8Charset(charset);
+    IconvPtr decoder(reinterpret_cast<iconv_t>(-1));
+    IconvPtr encoder(reinterpret_cast<iconv_t>(-1));
+    if (!passthrough) {
+        decoder.reset(iconv_open("UTF-8", charset.c_str()));
+        encoder.reset(iconv_open(charset.c_str(), "UTF-8"));
+        if (decoder.get() == reinterpret_cast<iconv_t>(-1) || encoder.get() == reinterpret_cast<iconv_t>(-1)) {
+            return fail("无法创建编码转换器: " + charset + " <-> UTF-8");
+        }
+    }
+
+    std::string encodePending;
+    std::string encoded;
+    bool writeFailed = false;
+    const TextSink sink = [&](const std::string_view part) {
+        if (passthrough) {
+            out.write(part.data(), static_cast<std::streamsize>(part.size()));
+            return;
+        }
+        // 窗口边界可能切开 utf8 多字节序列，剩余部分与下一片段一起转换
+        encodePending.append(part);
+        encoded.clear();
+        if (!convert(encoder.get(), encodePending, encoded)) {
+            writeFailed = true;
+        }
+        out.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+    };
+
+    std::vector<char> chunk(kChunkSize);
+    std::string raw;       // 尚未解码的原始字节
+    std::string decoded;   // 本次解码得到的 utf8
+    std::string text;      // 已解码、尚未定稿的文本
+    bool first = true;
+    bool pendingCR = false;
+    bool skipping = false;  // 正在原样跳过超过预读上限的代码块
+    bool inBody = false;
+
+    while (true) {
+        in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        const auto n = static_cast<size_t>(in.gcount());
+        const bool eof = n < chunk.size();
+        raw.append(chunk.data(), n);
+
+        // utf8 BOM 与 readToUtf8 一样去除
+        if (first) {
+            first = false;
+            if (raw.size() >= 3 && raw.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+                raw.erase(0, 3);
+            }
+        }
+
+        if (passthrough) {
+            appendNormalized(text, raw, pendingCR);
+            raw.clear();
+        } else {
+            decoded.clear();
+            if (!convert(decoder.get(), raw, decoded)) {
+                return fail("编码转换失败: " + std::string(strerror(errno)) + " " + path.string());
+            }
+            appendNormalized(text, decoded, pendingCR);
+        }
+        if (eof) {
+            if (!raw.empty()) {
+                return fail("文件末尾存在不完整的字符：" + path.string());
+            }
+            if (pendingCR) {
+                text.push_back('\n');
+            }
+        }
+
+        while (true) {
+            // 超长代码块的剩余部分原样写出，直到它的结束标记；末尾两个字符可能是被切开的 ```
+            if (skipping) {
+                const size_t end = splitter.skip(text, inBody);
+                const size_t verbatim = end != std::string::npos ? end
+                                        : eof ? text.size() : text.size() - std::min<size_t>(text.size(), 2);
+                sink(std::string_view(text).substr(0, verbatim));
+                text.erase(0, verbatim);
+                if (end == std::string::npos) {
+                    break;
+                }
+                skipping = false;
+                inBody = false;
+            }
+
+            const size_t done = eof ? text.size() : splitter.cut(text);
+            if (done > 0) {
+                auto r = func(std::string_view(text).substr(0, done), sink);
+                if (!r.success) {
+                    rt.logs.insert(rt.logs.end(), r.logs.begin(), r.logs.end());
+                    return fail("处理失败：" + path.string());
+                }
+                rt.modified |= r.modified;
+            }
+            const bool overflow = !eof && text.size() - done > kMaxLookAhead;
+            text.erase(0, done);
+            if (!overflow) {
+                break;
+            }
+            // 代码块长时间未闭合：不再预读，跳过它并保持之后代码块的配对与整篇处理一致
+            rt.logs.emplace_back(LOG_TYPE::Warn,
+                "代码块超过预读上限(" + std::to_string(kMaxLookAhead >> 20) + " MB)，原样保留：" + path.string());
+            skipping = true;
+        }
+
+        if (writeFailed || !out.good()) {
+            return fail("写入临时文件失败：" + tmp.string());
+        }
+        if (eof) {
+            break;
+        }
+    }
+    if (in.bad()) {
+        return fail("读取文件内容失败：" + path.string());
+    }
+    if (!encodePending.empty()) {
+        return fail("编码转换失败：" + path.string());
+    }
+
+    out.close();
+    std::error_code ec;
+    if (!rt.modified) {
+        fs::remove(tmp, ec);
+        rt.success = true;
+        rt.logs.emplace_back(LOG_TYPE::Info, "未发生修改：" + path.string());
+        return rt;
+    }
+
+    // 保留原文件权限后替换
+    fs::permissions(tmp, fs::status(path, ec).permissions(), ec);
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        return fail("保存失败：" + path.string() + " " + ec.message());
+    }
+    rt.success = true;
+    rt.logs.emplace_back(LOG_TYPE::Info, "处理完成(流式)：" + path.string());
+    return rt;
+}
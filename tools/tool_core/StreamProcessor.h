@@ -0,0 +1,36 @@
+//
+// Created by zerox on 2025/11/14.
+//
+
+#ifndef MDTOOL2_STREAMPROCESSOR_H
+#define MDTOOL2_STREAMPROCESSOR_H
+
+#include "../../global.h"
+
+
+// 超大文档的流式处理：按窗口读取、解码、处理并写出，内存占用与文件大小无关
+class StreamProcessor {
+public:
+    // 返回 buffer 中可以定稿的前缀长度，之后的内容留到下一个窗口(不能把代码块切成两半)
+    using CutFunc = size_t(*)(std::string_view buffer);
+    // 代码块超过预读上限仍未闭合时原样跳过它的剩余部分：buffer 接着上次跳过的位置，
+    // inBody 表示已经越过开始行；返回代码块结束之后的偏移，buffer 中还没有结束时返回 npos
+    using SkipFunc = size_t(*)(std::string_view buffer, bool& inBody);
+
+    struct Splitter {
+        CutFunc cut;
+        SkipFunc skip;
+    };
+    // 处理一个窗口，结果按顺序写入 sink
+    using WindowFunc = std::function<FinalFuncReturn(std::string_view window, const TextSink& sink)>;
+
+    static constexpr size_t kChunkSize = 4 << 20;        // 每次读取的字节数
+    static constexpr size_t kMaxLookAhead = 64 << 20;    // 未闭合代码块最多预读的字节数
+
+    // 结果先写入同目录临时文件，发生修改时替换原文件
+    static FinalFuncReturn run(const fs::path& path, const std::string& charset,
+                               const Splitter& splitter, const WindowFunc& func);
+};
+
+
+#endif //MDTOOL2_STREAMPROCESSOR_H
\ No newline at end of file
@@ -0,0 +1,346 @@
+//
+// Created by zerox on 2025/11/16.
+//
+
+#include "Table.h"
+#include "CodeBlock.h"
+
+#include <algorithm>
+#include <array>
+#include <map>
+
+
+namespace {
+    struct WidthRange {
+        char32_t first;
+        char32_t last;
+        uint8_t width;
+    };
+
+    // 宽度不为 1 的码点范围(East Asian Width 为 W/F 的字符、组合字符与零宽字符)
+    constexpr WidthRange kWidthRanges[] = {
+        {0x0000, 0x001F, 0}, {0x007F, 0x009F, 0}, {0x0300, 0x036F, 0}, {0x0483, 0x0489, 0},
+        {0x0591, 0x05BD, 0}, {0x0610, 0x061A, 0}, {0x064B, 0x065F, 0}, {0x0E31, 0x0E31, 0},
+        {0x0E34, 0x0E3A, 0}, {0x0E47, 0x0E4E, 0}, {0x1AB0, 0x1AFF, 0}, {0x1DC0, 0x1DFF, 0},
+        {0x200B, 0x200F, 0}, {0x2028, 0x202E, 0}, {0x2060, 0x2064, 0}, {0x20D0, 0x20FF, 0},
+        {0xFE00, 0xFE0F, 0}, {0xFE20, 0xFE2F, 0}, {0xFEFF, 0xFEFF, 0}, {0xE0100, 0xE01EF, 0},
+
+        {0x1100, 0x115F, 2}, {0x231A, 0x231B, 2}, {0x2329, 0x232A, 2}, {0x23E9, 0x23EC, 2},
+        {0x23F0, 0x23F0, 2}, {0x23F3, 0x23F3, 2}, {0x25FD, 0x25FE, 2}, {0x2614, 0x2615, 2},
+        {0x2648, 0x2653, 2}, {0x267F, 0x267F, 2}, {0x2693, 0x2693, 2}, {0x26A1, 0x26A1, 2},
+        {0x26AA, 0x26AB, 2}, {0x26BD, 0x26BE, 2}, {0x26C4, 0x26C5, 2}, {0x26CE, 0x26CE, 2},
+        {0x26D4, 0x26D4, 2}, {0x26EA, 0x26EA, 2}, {0x26F2, 0x26F3, 2}, {0x26F5, 0x26F5, 2},
+        {0x26FA, 0x26FA, 2}, {0x26FD, 0x26FD, 2}, {0x2705, 0x2705, 2}, {0x270A, 0x270B, 2},
+        {0x2728, 0x2728, 2}, {0x274C, 0x274C, 2}, {0x274E, 0x274E, 2}, {0x2753, 0x2755, 2},
+        {0x2757, 0x2757, 2}, {0x2795, 0x2797, 2}, {0x27B0, 0x27B0, 2}, {0x27BF, 0x27BF, 2},
+        {0x2B1B, 0x2B1C, 2}, {0x2B50, 0x2B50, 2}, {0x2B55, 0x2B55, 2}, {0x2E80, 0x303E, 2},
+        {0x3041, 0x33FF, 2}, {0x3400, 0x4DBF, 2}, {0x4E00, 0x9FFF, 2}, {0xA000, 0xA4CF, 2},
+        {0xA960, 0xA97F, 2}, {0xAC00, 0xD7A3, 2}, {0xF900, 0xFAFF, 2}, {0xFE10, 0xFE19, 2},
+        {0xFE30, 0xFE6F, 2}, {0xFF00, 0xFF60, 2}, {0xFFE0, 0xFFE6, 2}, {0x16FE0, 0x16FE4, 2},
+        {0x17000, 0x18AFF, 2}, {0x1B000, 0x1B2FF, 2}, {0x1F004, 0x1F004, 2}, {0x1F0CF, 0x1F0CF, 2},
+        {0x1F18E, 0x1F18E, 2}, {0x1F191, 0x1F19A, 2}, {0x1F200, 0x1F202, 2}, {0x1F210, 0x1F23B, 2},
+        {0x1F240, 0x1F248, 2}, {0x1F250, 0x1F251, 2}, {0x1F260, 0x1F265, 2}, {0x1F300, 0x1F320, 2},
+        {0x1F32D, 0x1F335, 2}, {0x1F337, 0x1F37C, 2}, {0x1F37E, 0x1F393, 2}, {0x1F3A0, 0x1F3CA, 2},
+        {0x1F3CF, 0x1F3D3, 2}, {0x1F3E0, 0x1F3F0, 2}, {0x1F3F4, 0x1F3F4, 2}, {0x1F3F8, 0x1F43E, 2},
+        {0x1F440, 0x1F440, 2}, {0x1F442, 0x1F4FC, 2}, {0x1F4FF, 0x1F53D, 2}, {0x1F54B, 0x1F54E, 2},
+        {0x1F550, 0x1F567, 2}, {0x1F57A, 0x1F57A, 2}, {0x1F595, 0x1F596, 2}, {0x1F5A4, 0x1F5A4, 2},
+        {0x1F5FB, 0x1F64F, 2}, {0x1F680, 0x1F6C5, 2}, {0x1F6CC, 0x1F6CC, 2}, {0x1F6D0, 0x1F6D2, 2},
+        {0x1F6D5, 0x1F6D7, 2}, {0x1F6EB, 0x1F6EC, 2}, {0x1F6F4, 0x1F6FC, 2}, {0x1F7E0, 0x1F7EB, 2},
+        {0x1F90C, 0x1F93A, 2}, {0x1F93C, 0x1F945, 2}, {0x1F947, 0x1F9FF, 2}, {0x1FA70, 0x1FAFF, 2},
+        {0x20000, 0x2FFFD, 2}, {0x30000, 0x3FFFD, 2},
+    };
+
+    // 两级查找表：高位索引到去重后的 256 码点块，块内每个码点一个字节
+    class WidthTable {
+    public:
+        WidthTable() {
+            stage1.resize(0x110000 >> 8);
+            std::map<std::array<uint8_t, 256>, uint16_t> unique;
+            std::array<uint8_t, 256> block{};
+            for (size_t b = 0; b < stage1.size(); ++b) {
+                const auto lo = static_cast<char32_t>(b << 8);
+                const auto hi = static_cast<char32_t>(lo + 0xFF);
+                block.fill(1);
+                for (const auto& r : kWidthRanges) {
+                    if (r.last < lo || r.first > hi) {
+                        continue;
+                    }
+                    for (char32_t cp = std::max(lo, r.first); cp <= std::min(hi, r.last); ++cp) {
+                        block[cp - lo] = r.width;
+                    }
+                }
+                auto [it, inserted] = unique.try_emplace(block, static_cast<uint16_t>(unique.size()));
+                if (inserted) {
+                    stage2.insert(stage2.end(), block.begin(), block.end());
+                }
+                stage1[b] = it->second;
+            }
+        }
+
+        unsigned operator()(const char32_t cp) const {
+            return stage2[(static_cast<size_t>(stage1[cp >> 8]) << 8) | (cp & 0xFF)];
+        }
+
+    private:
+        std::vector<uint16_t> stage1;
+        std::vector<uint8_t> stage2;
+    };
+
+    // 首次使用表格操作时才构建
+    const WidthTable& widthTable() {
+        static const WidthTable table;
+        return table;
+    }
+
+    enum class Align { None, Left, Center, Right };
+
+    struct Cell {
+        std::string_view text;
+        size_t width;
+    };
+
+    std::string_view trim(std::string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+            s.remove_prefix(1);
+        }
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+            s.remove_suffix(1);
+        }
+        return s;
+    }
+
+    // 按未转义的 | 拆分单元格，首尾的 | 可省略
+    std::vector<std::string_view> splitCells(std::string_view line) {
+        line = trim(line);
+        if (!line.empty() && line.front() == '|') {
+            line.remove_prefix(1);
+        }
+        if (!line.empty() && line.back() == '|' && (line.size() < 2 || line[line.size() - 2] != '\\')) {
+            line.remove_suffix(1);
+        }
+
+        std::vector<std::string_view> cells;
+        size_t begin = 0;
+        for (size_t i = 0; i < line.size(); ++i) {
+            if (line[i] == '\\') {
+                ++i;
+            } else if (line[i] == '|') {
+                cells.push_back(trim(line.substr(begin, i - begin)));
+                begin = i + 1;
+            }
+        }
+        cells.push_back(trim(line.substr(begin)));
+        return cells;
+    }
+
+    // 分隔行：每个单元格形如 :?-+:?
+    std::optional<std::vector<Align>> parseDelimiter(const std::string_view line) {
+        if (line.find('|') == std::string_view::npos) {
+            return std::nullopt;
+        }
+        std::vector<Align> aligns;
+        for (auto cell : splitCells(line)) {
+            const bool left = !cell.empty() && cell.front() == ':';
+            const bool right = cell.size() > 1 && cell.back() == ':';
+            if (left) {
+                cell.remove_prefix(1);
+            }
+            if (right) {
+                cell.remove_suffix(1);
+            }
+            if (cell.empty() || cell.find_first_not_of('-') != std::string_view::npos) {
+                return std::nullopt;
+            }
+            aligns.push_back(left && right ? Align::Center : right ? Align::Right : left ? Align::Left : Align::None);
+        }
+        return aligns;
+    }
+
+    void appendPadded(std::string& out, const Cell& cell, const size_t width, const Align align) {
+        const size_t pad = width - cell.width;
+        const size_t before = align == Align::Right ? pad : align == Align::Center ? pad / 2 : 0;
+        out.append(before, ' ');
+        out.append(cell.text);
+        out.append(pad - before, ' ');
+    }
+
+    // 重新生成一个表格，rows[1] 为分隔行(其单元格不使用)
+    std::string renderTable(const std::string_view indent, const std::vector<std::vector<Cell>>& rows,
+                            const std::vector<Align>& aligns) {
+        // 列数由表头决定：正文行中多出的单元格不参与对齐，原样保留在行末
+        const size_t columns = aligns.size();
+        std::vector<size_t> widths(columns, 3);
+        for (size_t r = 0; r < rows.size(); ++r) {
+            if (r == 1) {
+                continue;
+            }
+            for (size_t c = 0; c < std::min(columns, rows[r].size()); ++c) {
+                widths[c] = std::max(widths[c], rows[r][c].width);
+            }
+        }
+
+        std::string out;
+        const Cell empty{{}, 0};
+        for (size_t r = 0; r < rows.size(); ++r) {
+            if (r > 0) {
+                out.push_back('\n');
+            }
+            out.append(indent);
+            out.push_back('|');
+            for (size_t c = 0; c < columns; ++c) {
+                out.push_back(' ');
+                if (r == 1) {
+                    const Align a = aligns[c];
+                    const bool left = a == Align::Left || a == Align::Center;
+                    const bool right = a == Align::Right || a == Align::Center;
+                    out.push_back(left ? ':' : '-');
+                    out.append(widths[c] - 2, '-');
+                    out.push_back(right ? ':' : '-');
+                } else {
+                    appendPadded(out, c < rows[r].size() ? rows[r][c] : empty, widths[c], aligns[c]);
+                }
+                out.append(" |");
+            }
+            for (size_t c = columns; r != 1 && c < rows[r].size(); ++c) {
+                out.push_back(' ');
+                out.append(rows[r][c].text);
+                out.append(" |");
+            }
+        }
+        return out;
+    }
+
+    std::vector<Cell> measure(const std::vector<std::string_view>& cells) {
+        std::vector<Cell> row;
+        row.reserve(cells.size());
+        for (const auto cell : cells) {
+            row.push_back({cell, Table::displayWidth(cell)});
+        }
+        return row;
+    }
+}
+
+
+unsigned Table::codepointWidth(const char32_t cp) {
+    return cp < 0x110000 ? widthTable()(cp) : 1;
+}
+
+size_t Table::displayWidth(const std::string_view text) {
+    const auto* p = reinterpret_cast<const unsigned char*>(text.data());
+    const auto* end = p + text.size();
+    const WidthTable* table = nullptr;
+    size_t width = 0;
+
+    while (p < end) {
+        // ASCII 不查表
+        if (*p < 0x80) {
+            width += *p >= 0x20 && *p != 0x7F;
+            ++p;
+            continue;
+        }
+
+        // 直接在 utf8 字节上解码单个码点，非法序列按 1 列计算
+        size_t len;
+        char32_t cp;
+        if ((*p & 0xE0) == 0xC0) {
+            len = 2;
+            cp = *p & 0x1F;
+        } else if ((*p & 0xF0) == 0xE0) {
+            len = 3;
+            cp = *p & 0x0F;
+        } else if ((*p & 0xF8) == 0xF0) {
+            len = 4;
+            cp = *p & 0x07;
+        } else {
+            ++width;
+            ++p;
+            continue;
+        }
+        if (static_cast<size_t>(end - p) < len) {
+            width += static_cast<size_t>(end - p);
+            break;
+        }
+        for (size_t i = 1; i < len; ++i) {
+            cp = (cp << 6) | (p[i] & 0x3F);
+        }
+        if (!table) {
+            table = &widthTable();
+        }
+        width += cp < 0x110000 ? (*table)(cp) : 1;
+        p += len;
+    }
+    return width;
+}
+
+bool Table::format(const std::string_view text, const TextSink& sink) const {
+    // 收集每一行的范围
+    std::vector<std::pair<size_t, size_t>> lines;
+    for (size_t pos = 0; pos < text.size();) {
+        size_t nl = text.find('\n', pos);
+        if (nl == std::string_view::npos) {
+            nl = text.size();
+        }
+        lines.emplace_back(pos, nl);
+        pos = nl + 1;
+    }
+    const auto line = [&](const size_t i) {
+        return text.substr(lines[i].first, lines[i].second - lines[i].first);
+    };
+
+    // 与代码块有交集的行不参与表格识别
+    const auto blocks = CodeBlock::spans(text);
+    std::vector<bool> inBlock(lines.size(), false);
+    size_t b = 0;
+    for (size_t i = 0; i < lines.size() && b < blocks.size(); ++i) {
+        while (b < blocks.size() && blocks[b].second <= lines[i].first) {
+            ++b;
+        }
+        if (b < blocks.size() && blocks[b].first < lines[i].second + 1) {
+            inBlock[i] = true;
+        }
+    }
+
+    bool has_modification = false;
+    size_t last_end = 0;
+    for (size_t i = 0; i + 1 < lines.size(); ++i) {
+        if (inBlock[i] || inBlock[i + 1] || line(i).find('|') == std::string_view::npos) {
+            continue;
+        }
+        const auto header = splitCells(line(i));
+        const auto aligns = parseDelimiter(line(i + 1));
+        if (!aligns || aligns->size() != header.size()) {
+            continue;
+        }
+
+        // 表格在空行、不含 | 的行或代码块处结束
+        size_t last = i + 1;
+        while (last + 1 < lines.size() && !inBlock[last + 1] && !trim(line(last + 1)).empty() &&
+               line(last + 1).find('|') != std::string_view::npos) {
+            ++last;
+        }
+
+        std::vector<std::vector<Cell>> rows;
+        rows.reserve(last - i + 1);
+        rows.push_back(measure(header));
+        rows.emplace_back();
+        for (size_t r = i + 2; r <= last; ++r) {
+            rows.push_back(measure(splitCells(line(r))));
+        }
+
+        const std::string_view head = line(i);
+        const std::string_view indent = head.substr(0, head.find_first_not_of(" \t"));
+        const std::string rendered = renderTable(indent, rows, *aligns);
+        const size_t start = lines[i].first;
+        const size_t end = lines[last].second;
+        if (rendered != text.substr(start, end - start)) {
+            sink(text.substr(last_end, start - last_end));
+            sink(rendered);
+            last_end = end;
+            has_modification = true;
+        }
+        i = last;
+    }
+
+    sink(text.substr(last_end));
+    return has_modification;
+}
@@ -0,0 +1,25 @@
+//
+// Created by zerox on 2025/11/16.
+//
+
+#ifndef MDTOOL2_TABLE_H
+#define MDTOOL2_TABLE_H
+
+#include "../../global.h"
+
+
+// md表格(GFM)操作类
+class Table {
+public:
+    // 内存接口：对齐代码块之外所有表格的列宽，结果按顺序写入 sink，返回是否发生修改
+    bool format(std::string_view text, const TextSink& sink) const;
+
+    // utf8 文本的显示宽度：东亚宽字符计 2，组合字符等计 0，其余计 1
+    static size_t displayWidth(std::string_view text);
+
+    // 单个码点的显示宽度，使用两级查找表
+    static unsigned codepointWidth(char32_t cp);
+};
+
+
+#endif //MDTOOL2_TABLE_H
\ No newline at end of file
@@ -0,0 +1,71 @@
+//
+// Created by zerox on 2025/11/22.
+//
+
+#ifndef MDTOOL2_THREADBUDGET_H
+#define MDTOOL2_THREADBUDGET_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+
+// 整个进程共享的线程名额：正在处理文档的线程各占一个，文档内分区并行时只能借用空闲的名额
+// 文件夹模式下处理线程都在忙时大文档按单线程处理，其他线程空闲时(如只剩一个大文档)再分区并行
+class ThreadBudget {
+public:
+    // 占用一个名额，不检查上限：每个处理文档的线程总能运行
+    void hold() {
+        used.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 在占用数不超过 limit 的前提下取得至多 n 个名额，不等待，返回取得的个数
+    size_t tryAcquire(const size_t n, const size_t limit) {
+        size_t current = used.load(std::memory_order_relaxed);
+        while (true) {
+            const size_t take = current < limit ? std::min(n, limit - current) : 0;
+            if (take == 0) {
+                return 0;
+            }
+            if (used.compare_exchange_weak(current, current + take, std::memory_order_relaxed)) {
+                return take;
+            }
+        }
+    }
+
+    void release(const size_t n) {
+        used.fetch_sub(n, std::memory_order_relaxed);
+    }
+
+    // 当前线程在作用域内占用一个名额，已占用时不重复占用
+    class Slot {
+    public:
+        explicit Slot(ThreadBudget& budget) : budget(budget), owner(!holding) {
+            if (owner) {
+                budget.hold();
+                holding = true;
+            }
+        }
+
+        ~Slot() {
+            if (owner) {
+                holding = false;
+                budget.release(1);
+            }
+        }
+
+        Slot(const Slot&) = delete;
+        Slot& operator=(const Slot&) = delete;
+
+    private:
+        static inline thread_local bool holding = false;
+        ThreadBudget& budget;
+        bool owner;
+    };
+
+private:
+    std::atomic<size_t> used = 0;
+};
+
+
+#endif //MDTOOL2_THREADBUDGET_H
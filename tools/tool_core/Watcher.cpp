@@ -0,0 +1,212 @@
+//
+// Created by zerox on 2025/11/13.
+//
+
+#include "Watcher.h"
+#include "DirWalker.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+
+Watcher::~Watcher() {
+#ifdef __linux__
+    if (fd >= 0) {
+        close(fd);
+    }
+#endif
+}
+
+std::optional<Watcher::Stamp> Watcher::stampOf(const fs::path& path) {
+    std::error_code ec;
+    const auto mtime = fs::last_write_time(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    const auto size = fs::file_size(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    return Stamp{mtime, size};
+}
+
+#ifdef __linux__
+
+bool Watcher::addWatch(const fs::path& dir) {
+    constexpr uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+    const int wd = inotify_add_watch(fd, dir.c_str(), mask);
+    if (wd < 0) {
+        logs::print("无法监听文件夹：" + dir.string() + " " + strerror(errno), LOG_TYPE::Warn);
+        return false;
+    }
+    watches[wd] = dir;
+    return true;
+}
+
+void Watcher::addTree(const fs::path& dir, const bool queueFiles) {
+    // 与文件夹模式使用同样的忽略规则(包括 root 到 dir 之间各层的忽略文件)，被忽略的文件夹不监听
+    const auto now = std::chrono::steady_clock::now();
+    const DirWalker walker(0);
+    walker.walk(root, dir, [&](const fs::path& file) {
+        if (queueFiles) {
+            pending[file] = now;
+        }
+        return true;
+    }, [this](const fs::path& d) {
+        addWatch(d);
+        return true;
+    });
+}
+
+void Watcher::readEvents() {
+    alignas(inotify_event) char buffer[64 * 1024];
+    const ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n <= 0) {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    for (ssize_t offset = 0; offset < n;) {
+        const auto* ev = reinterpret_cast<const inotify_event*>(buffer + offset);
+        offset += static_cast<ssize_t>(sizeof(inotify_event) + ev->len);
+
+        if (ev->mask & IN_Q_OVERFLOW) {
+            logs::print("监听事件过多，部分修改可能被遗漏", LOG_TYPE::Warn);
+            continue;
+        }
+        if (ev->mask & IN_IGNORED) {
+            watches.erase(ev->wd);
+            continue;
+        }
+        const auto dir = watches.find(ev->wd);
+        if (dir == watches.end() || ev->len == 0) {
+            continue;
+        }
+
+        fs::path path = dir->second / ev->name;
+        if (ev->mask & IN_ISDIR) {
+            // 新建或移入的文件夹需要补充监听；移入的文件夹中已有的文档不会再产生事件，直接加入待处理
+            if (!singleFile && (ev->mask & (IN_CREATE | IN_MOVED_TO))) {
+                addTree(path, true);
+            }
+            continue;
+        }
+        if (!(ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))) {
+            continue;
+        }
+        if (singleFile ? path != *singleFile : !DirWalker::isMarkdown(path)) {
+            continue;
+        }
+        pending[std::move(path)] = now;
+    }
+}
+
+FinalFuncReturn Watcher::run() {
+    FinalFuncReturn rt;
+    fd = inotify_init1(IN_CLOEXEC);
+    if (fd < 0) {
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, "创建 inotify 失败：" + std::string(strerror(errno)))};
+        return rt;
+    }
+
+    std::error_code ec;
+    if (fs::is_directory(root, ec)) {
+        addTree(root, false);
+    } else {
+        const fs::path parent = root.has_parent_path() ? root.parent_path() : fs::path(".");
+        singleFile = parent / root.filename();
+        addWatch(parent);
+    }
+    if (watches.empty()) {
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, "没有可以监听的文件夹：" + root.string())};
+        return rt;
+    }
+    logs::print("开始监听：" + root.string() + "，共 " + std::to_string(watches.size()) + " 个文件夹",
+                LOG_TYPE::MainInfo);
+
+    while (true) {
+        const int timeout = pending.empty() ? -1 : static_cast<int>(kDebounce.count());
+        pollfd pfd{fd, POLLIN, 0};
+        const int ready = poll(&pfd, 1, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            rt.success = false;
+            rt.logs = {logs::alog(LOG_TYPE::Error, "等待监听事件失败：" + std::string(strerror(errno)))};
+            return rt;
+        }
+        if (ready > 0) {
+            readEvents();
+        }
+        flush();
+    }
+}
+
+#else
+
+bool Watcher::addWatch(const fs::path&) {
+    return false;
+}
+
+void Watcher::addTree(const fs::path&, bool) {}
+
+void Watcher::readEvents() {}
+
+FinalFuncReturn Watcher::run() {
+    FinalFuncReturn rt;
+    rt.success = false;
+    rt.logs = {logs::alog(LOG_TYPE::Error, "当前平台不支持 watch 模式")};
+    return rt;
+}
+
+#endif
+
+void Watcher::flush() {
+    const auto now = std::chrono::steady_clock::now();
+    for (auto it = pending.begin(); it != pending.end();) {
+        if (now - it->second >= kDebounce) {
+            handle(it->first);
+            it = pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void Watcher::handle(const fs::path& path) {
+    // 与文件夹模式一致，被忽略规则匹配的文档不处理；忽略文件可能随时修改，每次重新读取
+    if (!singleFile && DirWalker::isIgnored(root, path)) {
+        return;
+    }
+    const auto stamp = stampOf(path);
+    if (!stamp) {
+        // 保存后又被删除或移走
+        return;
+    }
+
+    // 自身写回产生的事件：文件状态与写回后记录的一致则跳过
+    if (const auto it = selfWrites.find(path); it != selfWrites.end()) {
+        const bool own = it->second == *stamp;
+        selfWrites.erase(it);
+        if (own) {
+            return;
+        }
+    }
+
+    const auto r = process(path);
+    if (r.output) {
+        std::cout << *r.output << std::endl;
+    }
+    logs::printLogs(r.logs, useLog);
+    if (r.modified) {
+        if (const auto written = stampOf(path)) {
+            selfWrites[path] = *written;
+        }
+    }
+}
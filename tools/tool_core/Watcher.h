@@ -0,0 +1,59 @@
+//
+// Created by zerox on 2025/11/13.
+//
+
+#ifndef MDTOOL2_WATCHER_H
+#define MDTOOL2_WATCHER_H
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include "../../global.h"
+
+
+// 常驻监听：文档保存后只对发生变化的 md 文档执行操作(目前仅支持 Linux inotify)
+class Watcher {
+public:
+    using ProcessFunc = std::function<FinalFuncReturn(const fs::path&)>;
+
+    // 同一文件在该时间内的连续事件合并为一次处理
+    static constexpr auto kDebounce = std::chrono::milliseconds(200);
+
+    Watcher(fs::path root, ProcessFunc process) : root(std::move(root)), process(std::move(process)) {}
+    ~Watcher();
+
+    Watcher(const Watcher&) = delete;
+    Watcher& operator=(const Watcher&) = delete;
+
+    // 阻塞运行，只在出错时返回
+    FinalFuncReturn run();
+
+private:
+    // 文件写入后的状态，用于识别自身写回产生的事件
+    struct Stamp {
+        fs::file_time_type mtime;
+        uintmax_t size;
+        bool operator==(const Stamp&) const = default;
+    };
+
+    static std::optional<Stamp> stampOf(const fs::path& path);
+
+    bool addWatch(const fs::path& dir);
+    // 监听 dir 及其下未被忽略的文件夹，queueFiles 时把其中已有的文档加入待处理
+    void addTree(const fs::path& dir, bool queueFiles);
+    void readEvents();
+    void flush();
+    void handle(const fs::path& path);
+
+    fs::path root;
+    ProcessFunc process;
+    std::optional<fs::path> singleFile;  // 只监听单个文档时的目标文件
+    int fd = -1;
+    std::unordered_map<int, fs::path> watches;
+    std::map<fs::path, std::chrono::steady_clock::time_point> pending;
+    std::map<fs::path, Stamp> selfWrites;
+};
+
+
+#endif //MDTOOL2_WATCHER_H
\ No newline at end of file
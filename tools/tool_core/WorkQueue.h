@@ -0,0 +1,85 @@
+//
+// Created by zerox on 2025/11/12.
+//
+
+#ifndef MDTOOL2_WORKQUEUE_H
+#define MDTOOL2_WORKQUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+
+// 多生产者多消费者阻塞队列，扫描线程边找边投递，工作线程边取边处理
+template <typename T>
+class WorkQueue {
+public:
+    // capacity 为 0 表示不限制长度
+    explicit WorkQueue(const size_t capacity = 0) : capacity(capacity) {}
+
+    // 队列已关闭时返回 false
+    bool push(T item) {
+        std::unique_lock lock(mutex);
+        notFull.wait(lock, [this] { return closed || capacity == 0 || items.size() < capacity; });
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // 队列关闭且已取空时返回 nullopt
+    std::optional<T> pop() {
+        std::unique_lock lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) {
+            return std::nullopt;
+        }
+        T item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return item;
+    }
+
+    // 不阻塞：队列暂时为空时返回 nullopt
+    std::optional<T> tryPop() {
+        std::lock_guard lock(mutex);
+        if (items.empty()) {
+            return std::nullopt;
+        }
+        T item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return item;
+    }
+
+    // 队列已关闭且已取空
+    bool finished() {
+        std::lock_guard lock(mutex);
+        return closed && items.empty();
+    }
+
+    // 不再接收新任务，已入队的任务仍会被取出
+    void close() {
+        {
+            std::lock_guard lock(mutex);
+            closed = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<T> items;
+    size_t capacity;
+    bool closed = false;
+};
+
+
+#endif //MDTOOL2_WORKQUEUE_H
\ No newline at end of file
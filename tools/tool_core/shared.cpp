@@ -44,12 +44,10 @@ std::optional<std::string> encoding::detect_file_charset(const char *filename) {
     const std::streamsize file_size = file.tellg();
     file.seekg(0, std::ios::beg);
 
-    // 创建检测器 (使用 RAII 智能指针)
-    UchardetPtr ud(uchardet_new());
-    if (!ud) {
-        logs::print("创建字符集检测器失败", LOG_TYPE::Error);
+    if (!resetDetector()) {
         return std::nullopt;
     }
+    uchardet_t ud = detector.get();
 
     // 分块读取文件并检测
     char buffer[BUFFER_SIZE];
@@ -58,7 +56,7 @@ std::optional<std::string> encoding::detect_file_charset(const char *filename) {
     while (file.read(buffer, BUFFER_SIZE) || file.gcount() > 0) {
         const std::streamsize len = file.gcount();
 
-        if (uchardet_handle_data(ud.get(), buffer, static_cast<size_t>(len)) != 0) {
+        if (uchardet_handle_data(ud, buffer, static_cast<size_t>(len)) != 0) {
             logs::print("处理数据失败", LOG_TYPE::Error);
             return std::nullopt;
         }
@@ -79,11 +77,90 @@ std::optional<std::string> encoding::detect_file_charset(const char *filename) {
         }
     }
 
+    return finishDetection();
+}
+
+std::optional<std::string> encoding::detect_charset(const std::string_view data) {
+    if (!resetDetector()) {
+        return std::nullopt;
+    }
+
+    const size_t len = std::min<size_t>(data.size(), MAX_DETECTION_SIZE);
+    if (uchardet_handle_data(detector.get(), data.data(), len) != 0) {
+        logs::print("处理数据失败", LOG_TYPE::Error);
+        return std::nullopt;
+    }
+    return finishDetection();
+}
+
+std::vector<encoding::Candidate> encoding::detect_candidates(const std::string_view data) {
+    std::vector<Candidate> candidates;
+    if (!resetDetector()) {
+        return candidates;
+    }
+
+    uchardet_t ud = detector.get();
+    const size_t len = std::min<size_t>(data.size(), MAX_DETECTION_SIZE);
+    if (uchardet_handle_data(ud, data.data(), len) != 0) {
+        logs::print("处理数据失败", LOG_TYPE::Error);
+        return candidates;
+    }
+    uchardet_data_end(ud);
+
+    const size_t count = uchardet_get_n_candidates(ud);
+    for (size_t i = 0; i < count; ++i) {
+        const char* charset = uchardet_get_encoding(ud, i);
+        if (charset && strlen(charset) > 0) {
+            candidates.push_back({charset, uchardet_get_confidence(ud, i)});
+        }
+    }
+    return candidates;
+}
+
+std::optional<std::string> encoding::toUtf8Lossless(const std::string_view raw, const std::string& charset) {
+    auto decoded = decodeToUtf8(raw, charset);
+    if (!decoded) {
+        return std::nullopt;
+    }
+
+    // 多个字节序列可能映射到同一字符(如 CP932 的重复字符)，必须重新编码后逐字节比较
+    const auto back = encodeFromUtf8(*decoded, charset);
+    if (!back) {
+        return std::nullopt;
+    }
+    if (charset.starts_with("UTF-16") || charset.starts_with("UTF-32")) {
+        // 宽字符编码的 BOM 与字节序在重新编码时可能不同，改为比较再次解码的结果
+        const auto again = decodeToUtf8(*back, charset);
+        return again && *again == *decoded ? decoded : std::nullopt;
+    }
+    if (*back != normalize_newlines(std::string(raw))) {
+        return std::nullopt;
+    }
+    return decoded;
+}
+
+bool encoding::resetDetector() {
+    // 检测器只创建一次，之后每个文件复用前 reset
+    if (!detector) {
+        detector.reset(uchardet_new());
+        if (!detector) {
+            logs::print("创建字符集检测器失败", LOG_TYPE::Error);
+            return false;
+        }
+    } else {
+        uchardet_reset(detector.get());
+    }
+    return true;
+}
+
+std::optional<std::string> encoding::finishDetection() {
+    uchardet_t ud = detector.get();
+
     // 完成检测
-    uchardet_data_end(ud.get());
+    uchardet_data_end(ud);
 
     // 获取结果
-    const char *charset = uchardet_get_charset(ud.get());
+    const char *charset = uchardet_get_charset(ud);
     if (!charset || strlen(charset) == 0) {
         logs::print("无法检测字符集，可能是二进制文件或编码复杂", LOG_TYPE::Error);
         return std::nullopt;
@@ -121,8 +198,13 @@ std::optional<std::string> encoding::readToUtf8(const char *filename, std::strin
         return std::nullopt;
     }
 
+    return decodeToUtf8(std::string_view(input.data(), input.size()), charset);
+}
+
+std::optional<std::string> encoding::decodeToUtf8(const std::string_view input, const std::string& charset)
+{
     // UTF-8 带 BOM → 去除 BOM，直接返回
-    if (file_size >= 3 &&
+    if (input.size() >= 3 &&
         static_cast<unsigned char>(input[0]) == 0xEF &&
         static_cast<unsigned char>(input[1]) == 0xBB &&
         static_cast<unsigned char>(input[2]) == 0xBF)
@@ -140,16 +222,15 @@ std::optional<std::string> encoding::readToUtf8(const char *filename, std::strin
     }
 
     // 初始化 iconv：目标 UTF-8
-    iconv_t cd_raw = iconv_open("UTF-8", charset.c_str());
-    if (cd_raw == reinterpret_cast<iconv_t>(-1)) {
+    const iconv_t cd = converter("UTF-8", charset);
+    if (cd == reinterpret_cast<iconv_t>(-1)) {
         logs::print("无法创建编码转换器: " + charset + " -> UTF-8", LOG_TYPE::Error);
         return std::nullopt;
     }
-    IconvPtr cd(cd_raw);
 
     // 转换缓冲区，动态扩展
     size_t in_left  = input.size();
-    char* in_ptr    = input.data();
+    char* in_ptr    = const_cast<char*>(input.data());
 
     std::vector<char> output;
     output.reserve(input.size() * 2);
@@ -161,7 +242,7 @@ std::optional<std::string> encoding::readToUtf8(const char *filename, std::strin
         char* out_ptr = temp.data();
         size_t out_left = CHUNK;
 
-        size_t res = iconv(cd.get(), &in_ptr, &in_left, &out_ptr, &out_left);
+        size_t res = iconv(cd, &in_ptr, &in_left, &out_ptr, &out_left);
 
         size_t produced = CHUNK - out_left;
         output.insert(output.end(), temp.data(), temp.data() + produced);
@@ -200,38 +281,44 @@ bool encoding::saveUtf8ToFile(const char *filename, const std::string& data,
         return false;
     }
 
-    auto chrst = charset.c_str();
+    const auto output = encodeFromUtf8(data, charset);
+    if (!output) {
+        return false;
+    }
 
-    // 如果目标编码是 UTF-8 或未指定，直接写入
-    if (!chrst || strlen(chrst) == 0 || strcmp(chrst, "UTF-8") == 0) {
-        std::ofstream file(filename, std::ios::binary);
-        if (!file.is_open()) {
-            logs::print("打开文件失败: " + std::string(filename), LOG_TYPE::Error);
-            return false;
-        }
+    // 写入文件
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        logs::print("打开文件失败: " + std::string(filename), LOG_TYPE::Error);
+        return false;
+    }
 
-        // data.c_str() 返回 const char*，不再需要 to_char
-        file.write(data.c_str(), static_cast<std::streamsize>(data.size()));
+    file.write(output->data(), static_cast<std::streamsize>(output->size()));
 
-        if (!file.good()) {
-            logs::print("写入文件失败: " + std::string(filename), LOG_TYPE::Error);
-            return false;
-        }
+    if (!file.good()) {
+        logs::print("写入文件失败: " + std::string(filename), LOG_TYPE::Error);
+        return false;
+    }
 
-        return true;
+    return true;
+}
+
+std::optional<std::string> encoding::encodeFromUtf8(const std::string& data, const std::string& charset) {
+    auto chrst = charset.c_str();
+
+    // 如果目标编码是 UTF-8 或未指定，直接返回
+    if (!chrst || strlen(chrst) == 0 || strcmp(chrst, "UTF-8") == 0) {
+        return data;
     }
 
     // 初始化 iconv 转换器 (UTF-8 -> 目标编码)
-    iconv_t cd_raw = iconv_open(chrst, "UTF-8");
+    const iconv_t cd_raw = converter(charset, "UTF-8");
     if (cd_raw == reinterpret_cast<iconv_t>(-1)) {
         logs::print("无法创建编码转换器: UTF-8 -> " + std::string(chrst),
                    LOG_TYPE::Error);
-        return false;
+        return std::nullopt;
     }
 
-    // 使用 RAII 管理 iconv
-    IconvPtr cd(cd_raw);
-
     // 准备输入数据
     size_t input_left = data.size();
     // data.c_str() 返回 const char*
@@ -240,7 +327,7 @@ bool encoding::saveUtf8ToFile(const char *filename, const std::string& data,
 
     // 准备输出缓冲区
     size_t output_size = data.size() * 4;
-    std::vector<char> output_buffer(output_size);
+    std::string output_buffer(output_size, '\0');
     size_t output_left = output_size;
     char* output_ptr = output_buffer.data();
 
@@ -250,36 +337,106 @@ bool encoding::saveUtf8ToFile(const char *filename, const std::string& data,
     if (result == static_cast<size_t>(-1)) {
         logs::print("编码转换失败: UTF-8 -> " + std::string(chrst) +
                    ": " + std::string(strerror(errno)), LOG_TYPE::Error);
-        return false;
+        return std::nullopt;
     }
 
     // 计算转换后的数据大小
-    size_t converted_size = output_size - output_left;
+    output_buffer.resize(output_size - output_left);
+    return output_buffer;
+}
 
-    // 写入文件
-    std::ofstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        logs::print("打开文件失败: " + std::string(filename), LOG_TYPE::Error);
-        return false;
+
+iconv_t encoding::converter(const std::string& to, const std::string& from) {
+    const std::string key = from + ">" + to;
+    if (const auto it = converters.find(key); it != converters.end()) {
+        // 复用前清空上一次转换遗留的移位状态
+        iconv(it->second.get(), nullptr, nullptr, nullptr, nullptr);
+        return it->second.get();
     }
 
-    file.write(output_buffer.data(), static_cast<std::streamsize>(converted_size));
+    const iconv_t cd = iconv_open(to.c_str(), from.c_str());
+    if (cd == reinterpret_cast<iconv_t>(-1)) {
+        return cd;
+    }
+    converters.emplace(key, IconvPtr(cd));
+    return cd;
+}
 
-    if (!file.good()) {
-        logs::print("写入文件失败: " + std::string(filename), LOG_TYPE::Error);
-        return false;
+std::optional<std::string> encoding::cachedCharset(const std::string& filename) const {
+    if (const auto it = charsetCache.find(filename); it != charsetCache.end()) {
+        return it->second;
     }
+    return std::nullopt;
+}
 
-    return true;
+void encoding::rememberCharset(const std::string& filename, const std::string& charset) {
+    charsetCache[filename] = charset;
 }
 
+void encoding::forgetCharset(const std::string& filename) {
+    charsetCache.erase(filename);
+}
 
-std::tuple<std::string, std::string> tool::splitFromLine(
-    const std::string& data, const int line)
+bool tool::isUtf8(const std::string_view data) {
+    const auto* p = reinterpret_cast<const unsigned char*>(data.data());
+    const auto* end = p + data.size();
+    while (p < end) {
+        // ASCII 快速跳过，8 字节一组
+        while (end - p >= 8) {
+            uint64_t word;
+            memcpy(&word, p, 8);
+            if (word & 0x8080808080808080ULL) {
+                break;
+            }
+            p += 8;
+        }
+        if (p >= end) {
+            break;
+        }
+        const unsigned char c = *p;
+        if (c < 0x80) {
+            ++p;
+            continue;
+        }
+
+        size_t len;
+        uint32_t cp;
+        if ((c & 0xE0) == 0xC0) {
+            len = 2;
+            cp = c & 0x1F;
+        } else if ((c & 0xF0) == 0xE0) {
+            len = 3;
+            cp = c & 0x0F;
+        } else if ((c & 0xF8) == 0xF0) {
+            len = 4;
+            cp = c & 0x07;
+        } else {
+            return false;
+        }
+        if (static_cast<size_t>(end - p) < len) {
+            return false;
+        }
+        for (size_t i = 1; i < len; ++i) {
+            if ((p[i] & 0xC0) != 0x80) {
+                return false;
+            }
+            cp = (cp << 6) | (p[i] & 0x3F);
+        }
+        // 拒绝过长编码、代理区与超出范围的码点
+        if ((len == 2 && cp < 0x80) || (len == 3 && cp < 0x800) || (len == 4 && cp < 0x10000) ||
+            cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+            return false;
+        }
+        p += len;
+    }
+    return true;
+}
+
+size_t tool::splitPos(const std::string_view data, const int line)
 {
     // line == 0：不分割
     if (data.empty() || line == 0) {
-        return {data, ""};
+        return data.size();
     }
 
     // 收集每一行的起始位置
@@ -301,7 +458,6 @@ std::tuple<std::string, std::string> tool::splitFromLine(
     }
 
     const int total_lines = static_cast<int>(line_positions.size());
-    size_t split_pos = 0;
 
     // ------------------------------------------------------------
     // line > 0 ：目标行属于第二部分
@@ -309,35 +465,38 @@ std::tuple<std::string, std::string> tool::splitFromLine(
     if (line > 0) {
         if (line > total_lines) {
             // 行超范围 → 完全放左边
-            return {data, ""};
+            return data.size();
         }
 
         // line 行的起始位置进入第二部分
-        split_pos = line_positions[line - 1];
+        return line_positions[line - 1];
     }
 
     // ------------------------------------------------------------
     // line < 0 ：目标行属于第一部分
     // ------------------------------------------------------------
-    else {
-        int from_end = -line;
+    const int from_end = -line;
 
-        if (from_end > total_lines) {
-            // 倒数行超范围 → 全部放右边
-            return {"", data};
-        }
+    if (from_end > total_lines) {
+        // 倒数行超范围 → 全部放右边
+        return 0;
+    }
 
-        // 倒数第 from_end 行
-        int target_line_index = total_lines - from_end;
+    // 倒数第 from_end 行
+    const int target_line_index = total_lines - from_end;
 
-        // 该行应该属于第一部分 → 第二部分从下一行开始
-        if (target_line_index + 1 < total_lines) {
-            split_pos = line_positions[target_line_index + 1];
-        } else {
-            // 最后一行被划入第一部分 → 第二部分为空
-            split_pos = data.size();
-        }
+    // 该行应该属于第一部分 → 第二部分从下一行开始
+    if (target_line_index + 1 < total_lines) {
+        return line_positions[target_line_index + 1];
     }
+    // 最后一行被划入第一部分 → 第二部分为空
+    return data.size();
+}
+
+std::tuple<std::string, std::string> tool::splitFromLine(
+    const std::string& data, const int line)
+{
+    const size_t split_pos = splitPos(data, line);
 
     // 执行分割
     std::string first_part  = data.substr(0, split_pos);
@@ -345,3 +504,69 @@ std::tuple<std::string, std::string> tool::splitFromLine(
 
     return {first_part, second_part};
 }
+
+std::string tool::sha256(const std::string_view data) {
+    static constexpr uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+    uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    const auto rotr = [](const uint32_t x, const int n) { return x >> n | x << (32 - n); };
+
+    const auto compress = [&](const unsigned char* block) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = uint32_t(block[4 * i]) << 24 | uint32_t(block[4 * i + 1]) << 16 |
+                   uint32_t(block[4 * i + 2]) << 8 | uint32_t(block[4 * i + 3]);
+        }
+        for (int i = 16; i < 64; ++i) {
+            const uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ w[i - 15] >> 3;
+            const uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ w[i - 2] >> 10;
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+        for (int i = 0; i < 64; ++i) {
+            const uint32_t t1 = hh + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            const uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            hh = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+        h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+    };
+
+    const auto* p = reinterpret_cast<const unsigned char*>(data.data());
+    size_t left = data.size();
+    for (; left >= 64; left -= 64, p += 64) {
+        compress(p);
+    }
+
+    // 末尾补 0x80、若干 0 与 64 位长度(位)
+    unsigned char tail[128] = {};
+    std::memcpy(tail, p, left);
+    tail[left] = 0x80;
+    const size_t tailSize = left < 56 ? 64 : 128;
+    const uint64_t bits = static_cast<uint64_t>(data.size()) * 8;
+    for (int i = 0; i < 8; ++i) {
+        tail[tailSize - 1 - i] = static_cast<unsigned char>(bits >> (8 * i));
+    }
+    compress(tail);
+    if (tailSize == 128) {
+        compress(tail + 64);
+    }
+
+    static constexpr char digits[] = "0123456789abcdef";
+    std::string hex(64, '0');
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            hex[i * 8 + j] = digits[h[i] >> (28 - 4 * j) & 0xF];
+        }
+    }
+    return hex;
+}
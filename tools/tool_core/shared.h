@@ -7,15 +7,21 @@
 
 #include <uchardet/uchardet.h>
 #include <iconv.h>
+#include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <optional>
 #include <tuple> // 引入 tuple
+#include <unordered_map>
 #include "../../global.h"
 
 // 标准化换行符
 std::string normalize_newlines(const std::string& str);
 
+// 输出接收器：按顺序接收处理结果片段，未修改的部分直接引用输入，不做拷贝
+using TextSink = std::function<void(std::string_view)>;
+
 #define BUFFER_SIZE 65536
 #define MAX_DETECTION_SIZE (BUFFER_SIZE * 49)
 
@@ -55,6 +61,38 @@ public:
 
     bool saveUtf8ToFile(const char *filename, const std::string& data,
                         const std::string& charset= nullptr);
+
+    // 内存版本：调用方已读入文件内容时使用，避免重复读取
+    std::optional<std::string> detect_charset(std::string_view data);
+    std::optional<std::string> decodeToUtf8(std::string_view input, const std::string& charset);
+    std::optional<std::string> encodeFromUtf8(const std::string& data, const std::string& charset);
+
+    // 全部候选字符集及可信度(0~1)，按可信度从高到低排列，检测失败时为空
+    struct Candidate {
+        std::string charset;
+        float confidence = 0;
+    };
+    std::vector<Candidate> detect_candidates(std::string_view data);
+
+    // 解码为 utf8，并确认重新编码后与原始字节一致(换行统一为 \n 后比较)，否则返回 nullopt
+    std::optional<std::string> toUtf8Lossless(std::string_view raw, const std::string& charset);
+
+    // 字符集缓存：长期运行时记录每个文件上次检测到的字符集
+    std::optional<std::string> cachedCharset(const std::string& filename) const;
+    void rememberCharset(const std::string& filename, const std::string& charset);
+    void forgetCharset(const std::string& filename);
+
+private:
+    bool resetDetector();
+    std::optional<std::string> finishDetection();
+
+    // 获取 from -> to 的转换器，同一对象内复用，失败返回 (iconv_t)-1
+    iconv_t converter(const std::string& to, const std::string& from);
+
+    // 以下资源在同一个 encoding 对象内复用，对象本身不是线程安全的
+    UchardetPtr detector;
+    std::unordered_map<std::string, IconvPtr> converters;
+    std::unordered_map<std::string, std::string> charsetCache;
 };
 
 class tool {
@@ -62,6 +100,15 @@ public:
     // 将文本按行进行一分为二
     static std::tuple<std::string, std::string> splitFromLine(
         const std::string& data, int line);
+
+    // 计算 splitFromLine 的分割位置，不复制文本
+    static size_t splitPos(std::string_view data, int line);
+
+    // 检查文本是否为合法 utf8
+    static bool isUtf8(std::string_view data);
+
+    // SHA-256，返回 64 位小写十六进制字符串
+    static std::string sha256(std::string_view data);
 };
 
 #endif //MDTOOL2_SHARED_H
\ No newline at end of file
@@ -2,4 +2,1098 @@
 // Created by zerox on 2025/11/10.
 //
 
-#include "tools.h"
\ No newline at end of file
+#include "tools.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "tool_core/CodeBlock.h"
+#include "tool_core/CodeExport.h"
+#include "tool_core/DirWalker.h"
+#include "tool_core/FrontMatter.h"
+#include "tool_core/GitRepo.h"
+#include "tool_core/IoBackend.h"
+#include "tool_core/StreamProcessor.h"
+#include "tool_core/Table.h"
+#include "tool_core/ThreadBudget.h"
+#include "tool_core/Watcher.h"
+#include "tool_core/WorkQueue.h"
+
+
+namespace {
+    // 单个操作在内存文本上的实现，结果按顺序写入 sink
+    using TextFunc = FinalFuncReturn(*)(std::string_view text, const tools::Operation& op,
+                                        const InputOptions& options, const TextSink& sink);
+
+    // 把文本切分为至多 parts 个互不影响的分区，返回各分区起点
+    using PartitionFunc = std::vector<size_t>(*)(std::string_view text, size_t parts);
+
+    // 需要文件路径或原始字节的操作：直接处理读入的内容，需要写回时放入 output
+    using FileFunc = FinalFuncReturn(*)(const fs::path& path, std::string_view raw, const tools::Operation& op,
+                                        const InputOptions& options, std::string& output);
+
+    // 整次运行结束后调用一次，如写出汇总文件；complete 表示本次运行成功处理了全部文档
+    using FinishFunc = FinalFuncReturn(*)(const tools::Operation& op, const InputOptions& options, bool complete);
+
+    // 自行读写文件的操作：只读取需要的部分，不整篇读入
+    using PathFunc = FinalFuncReturn(*)(const fs::path& path, const tools::Operation& op,
+                                        const InputOptions& options);
+
+    // 每个分区至少的大小，文档过小时并行得不偿失
+    constexpr size_t kMinPartSize = 1 << 20;
+    // 流式处理时窗口只是文档的一部分，窗口内每个分区至少的大小
+    constexpr size_t kMinWindowPart = 256 << 10;
+
+    // 文件夹模式下同时进行中的读写请求数
+    constexpr unsigned kIoDepth = 64;
+
+    const CodeBlock cb;
+    const Table tb;
+
+    // 每个线程一个 encoding，检测器与 iconv 转换器在多个文件间复用
+    encoding& threadEncoding() {
+        thread_local encoding enc;
+        return enc;
+    }
+
+    std::optional<std::string> readRaw(const fs::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return std::nullopt;
+        }
+        file.seekg(0, std::ios::end);
+        const std::streamsize size = file.tellg();
+        file.seekg(0, std::ios::beg);
+        if (size < 0) {
+            return std::nullopt;
+        }
+        std::string data(static_cast<size_t>(size), '\0');
+        if (!file.read(data.data(), size)) {
+            return std::nullopt;
+        }
+        return data;
+    }
+
+    bool writeRaw(const fs::path& path, const std::string_view data) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        return file.good();
+    }
+
+    // utf8 文档带 BOM 或含 \r 时仍需经过 decodeToUtf8 去除 BOM、统一换行
+    bool needsDecode(const std::string_view raw) {
+        return raw.starts_with("\xEF\xBB\xBF") || raw.find('\r') != std::string_view::npos;
+    }
+
+    // 解码后的文档：合法 utf8 直接引用原始内容，否则 buffer 保存转换结果
+    struct Document {
+        std::string charset;
+        std::optional<std::string> buffer;
+        std::string_view raw;
+
+        std::string_view text() const {
+            return buffer ? std::string_view(*buffer) : raw;
+        }
+    };
+
+    // 检测字符集并解码为 utf8，失败时返回 nullopt 并把错误写入 rt
+    std::optional<Document> decodeDocument(const std::string& filename, const std::string_view raw,
+                                           const InputOptions& options, FinalFuncReturn& rt) {
+        encoding& enc = threadEncoding();
+        Document doc{"UTF-8", std::nullopt, raw};
+
+        // 合法 utf8(包括纯 ASCII)直接引用原始内容处理，不检测字符集，也不经过 iconv
+        const bool utf8 = tool::isUtf8(raw);
+        const bool decode = !utf8 || needsDecode(raw);
+        if (utf8) {
+            if (decode) {
+                doc.buffer = enc.decodeToUtf8(raw, doc.charset);
+            }
+        } else {
+            // watch 模式下优先使用上次检测到的字符集，解码失败时重新检测
+            auto charset = options.watch ? enc.cachedCharset(filename) : std::nullopt;
+            if (charset && *charset != "UTF-8" && *charset != "ASCII") {
+                doc.buffer = enc.decodeToUtf8(raw, *charset);
+            }
+            if (!doc.buffer) {
+                charset = enc.detect_charset(raw);
+                if (!charset) {
+                    rt.success = false;
+                    rt.logs = {logs::alog(LOG_TYPE::Error, "检测字符集遇到错误：" + filename)};
+                    return std::nullopt;
+                }
+                doc.buffer = enc.decodeToUtf8(raw, *charset);
+            }
+            doc.charset = *charset;
+            if (options.watch) {
+                enc.rememberCharset(filename, doc.charset);
+            }
+        }
+        if (decode && !doc.buffer) {
+            rt.success = false;
+            rt.logs = {logs::alog(LOG_TYPE::Error, "读取文件为utf8遇到错误：" + filename)};
+            return std::nullopt;
+        }
+        return doc;
+    }
+
+    // 清单中记录的文档路径：相对 -p 指定的文件夹(或单个文档所在文件夹)，以 / 分隔
+    std::string relativeName(const fs::path& path, const InputOptions& options) {
+        std::error_code ec;
+        const fs::path base = fs::is_directory(options.path, ec) ? options.path : options.path.parent_path();
+        const fs::path rel = fs::absolute(path, ec).lexically_normal()
+            .lexically_relative(fs::absolute(base, ec).lexically_normal());
+        const std::string name = rel.generic_string();
+        return name.empty() || name.starts_with("..") ? path.generic_string() : name;
+    }
+
+    FinalFuncReturn cbLiAdd(const std::string_view text, const tools::Operation& op,
+                            const InputOptions& options, const TextSink& sink) {
+        FinalFuncReturn rt;
+        const std::string& language = op.args.empty() ? options.input : op.args.front();
+        if (language.empty()) {
+            rt.success = false;
+            rt.logs = {logs::alog(LOG_TYPE::Error, "未指定要添加的语言，请使用 -i 输入")};
+            return rt;
+        }
+        rt.modified = cb.li.add(text, language, sink);
+        rt.success = true;
+        return rt;
+    }
+
+    FinalFuncReturn cbCtAdd(const std::string_view text, const tools::Operation&,
+                            const InputOptions& options, const TextSink& sink) {
+        FinalFuncReturn rt;
+        if (options.input.empty()) {
+            rt.success = false;
+            rt.logs = {logs::alog(LOG_TYPE::Error, "未指定要添加的内容，请使用 -i 输入")};
+            return rt;
+        }
+        rt.modified = cb.ct.add(text, options.input, options.number, sink);
+        rt.success = true;
+        return rt;
+    }
+
+    // 附加参数为 "开头行数 结尾行数"，只有一个参数时与 -n 相同：正数为开头、负数为结尾
+    // 没有附加参数时使用 -n
+    FinalFuncReturn cbCtDel(const std::string_view text, const tools::Operation& op,
+                            const InputOptions& options, const TextSink& sink) {
+        FinalFuncReturn rt;
+        const bool pair = op.args.size() > 1;
+        long long first = options.number;
+        long long second = 0;
+        bool valid = true;
+        try {
+            if (!op.args.empty()) {
+                first = std::stoll(op.args[0]);
+                second = pair ? std::stoll(op.args[1]) : 0;
+            }
+        } catch (const std::exception&) {
+            valid = false;
+        }
+        if (!valid || second < 0 || (pair && first < 0)) {
+            rt.success = false;
+            rt.logs = {logs::alog(LOG_TYPE::Error, "删除行数无效：" + options.option)};
+            return rt;
+        }
+        const size_t head = first > 0 ? static_cast<size_t>(first) : 0;
+        const size_t tail = pair ? static_cast<size_t>(second) : first < 0 ? static_cast<size_t>(-first) : 0;
+        if (head == 0 && tail == 0) {
+            rt.success = false;
+            rt.logs = {logs::alog(LOG_TYPE::Error, "未指定要删除的行数，请使用 -n 输入")};
+            return rt;
+        }
+        rt.modified = cb.ct.del(text, head, tail, sink);
+        rt.success = true;
+        return rt;
+    }
+
+    FinalFuncReturn cbCtFormat(const std::string_view text, const tools::Operation&,
+                               const InputOptions&, const TextSink& sink) {
+        FinalFuncReturn rt;
+        rt.modified = cb.ct.format(text, sink);
+        rt.success = true;
+        return rt;
+    }
+
+    FinalFuncReturn tbFormat(const std::string_view text, const tools::Operation&,
+                             const InputOptions&, const TextSink& sink) {
+        FinalFuncReturn rt;
+        rt.modified = tb.format(text, sink);
+        rt.success = true;
+        return rt;
+    }
+
+    // 检测结果低于该可信度，或前两个候选相差不到 kMinConfidenceGap 时视为不确定
+    constexpr float kMinConfidence = 0.5f;
+    constexpr float kMinConfidenceGap = 0.1f;
+
+    // en utf8 的参数：bom 写入 BOM，crlf/lf 换行风格(默认 lf)，force 检测结果不确定时仍然转换
+    struct Utf8Target {
+        bool bom = false;
+        bool crlf = false;
+        bool force = false;
+    };
+
+    std::optional<Utf8Target> parseUtf8Target(const tools::Operation& op, std::string& error) {
+        Utf8Target target;
+        for (const auto& arg : op.args) {
+            if (arg == "bom") {
+                target.bom = true;
+            } else if (arg == "crlf") {
+                target.crlf = true;
+            } else if (arg == "lf") {
+                target.crlf = false;
+            } else if (arg == "force") {
+                target.force = true;
+            } else {
+                error = "未知的参数：" + arg;
+                return std::nullopt;
+            }
+        }
+        return target;
+    }
+
+    // 内存接口只处理换行风格：text 已是 utf8，BOM 属于文件层面，由 normalizeEncoding 写入
+    FinalFuncReturn enUtf8(const std::string_view text, const tools::Operation& op,
+                           const InputOptions&, const TextSink& sink) {
+        FinalFuncReturn rt;
+        std::string error;
+        const auto target = parseUtf8Target(op, error);
+        if (!target) {
+            rt.success = false;
+            rt.logs = {logs::alog(LOG_TYPE::Error, error)};
+            return rt;
+        }
+        rt.success = true;
+
+        // \r\n、\r、\n 统一为目标换行，已经符合的部分不拆分
+        const std::string_view newline = target->crlf ? "\r\n" : "\n";
+        size_t last = 0;
+        for (size_t pos = text.find_first_of("\r\n"); pos != std::string_view::npos;) {
+            const size_t len = text[pos] == '\r' && pos + 1 < text.size() && text[pos + 1] == '\n' ? 2 : 1;
+            if (text.substr(pos, len) != newline) {
+                sink(text.substr(last, pos - last));
+                sink(newline);
+                last = pos + len;
+                rt.modified = true;
+            }
+            pos = text.find_first_of("\r\n", pos + len);
+        }
+        sink(text.substr(last));
+        return rt;
+    }
+
+    // en utf8 直接作用于原始字节：检测字符集，确认可以无损转换后按目标格式输出 utf8
+    FinalFuncReturn normalizeEncoding(const fs::path& path, const std::string_view raw, const tools::Operation& op,
+                                      const InputOptions& options, std::string& output) {
+        FinalFuncReturn rt;
+        const std::string filename = path.string();
+        std::string error;
+        const auto target = parseUtf8Target(op, error);
+        if (!target) {
+            rt.success = false;
+            rt.logs = {logs::alog(LOG_TYPE::Error, error)};
+            return rt;
+        }
+
+        encoding& enc = threadEncoding();
+        std::string charset = "UTF-8";
+        std::optional<std::string> decoded;
+        if (tool::isUtf8(raw)) {
+            decoded = enc.decodeToUtf8(raw, charset);
+        } else {
+            const auto candidates = enc.detect_candidates(raw);
+            if (candidates.empty()) {
+                rt.success = false;
+                rt.logs = {logs::alog(LOG_TYPE::Error, "检测字符集遇到错误：" + filename)};
+                return rt;
+            }
+            charset = candidates[0].charset;
+
+            const auto describe = [&] {
+                std::string text;
+                for (size_t i = 0; i < std::min<size_t>(candidates.size(), 3); ++i) {
+                    text += (i ? "，" : "") + candidates[i].charset + " " +
+                            std::to_string(static_cast<int>(candidates[i].confidence * 100)) + "%";
+                }
+                return text;
+            };
+            const bool ambiguous = candidates[0].confidence < kMinConfidence ||
+                                   (candidates.size() > 1 && candidates[1].charset != charset &&
+                                    candidates[0].confidence - candidates[1].confidence < kMinConfidenceGap);
+            if (ambiguous && !target->force) {
+                rt.success = true;
+                rt.logs = {logs::alog(LOG_TYPE::Warn, "字符集检测结果不确定，未转换：" + filename +
+                                                      "（" + describe() + "），确认后可加 force 参数")};
+                return rt;
+            }
+
+            decoded = enc.toUtf8Lossless(raw, charset);
+            if (!decoded) {
+                rt.success = false;
+                rt.logs = {logs::alog(LOG_TYPE::Error, "无法从 " + charset + " 无损转换为utf8，未转换：" + filename)};
+                return rt;
+            }
+        }
+        if (!decoded) {
+            rt.success = false;
+            rt.logs = {logs::alog(LOG_TYPE::Error, "读取文件为utf8遇到错误：" + filename)};
+            return rt;
+        }
+
+        output.clear();
+        output.reserve(decoded->size() + decoded->size() / 16 + 3);
+        if (target->bom) {
+            output = "\xEF\xBB\xBF";
+        }
+        rt = enUtf8(*decoded, op, options, [&output](const std::string_view part) {
+            output.append(part);
+        });
+        rt.modified = output != raw;
+        if (!rt.modified) {
+            output.clear();
+            rt.logs.emplace_back(LOG_TYPE::Info, "未发生修改：" + filename);
+        } else if (charset != "UTF-8") {
+            rt.logs.emplace_back(LOG_TYPE::Info, "已从 " + charset + " 转换为utf8：" + filename);
+        }
+        return rt;
+    }
+
+    // cb export 的输出目录：附加参数或 -i
+    const std::string& exportDir(const tools::Operation& op, const InputOptions& options) {
+        return op.args.empty() ? options.input : op.args.front();
+    }
+
+    FinalFuncReturn cbExport(const std::string_view, const tools::Operation&,
+                             const InputOptions&, const TextSink&) {
+        FinalFuncReturn rt;
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, "cb export 需要文档路径，只能作用于文件")};
+        return rt;
+    }
+
+    FinalFuncReturn cbExportFile(const fs::path& path, const std::string_view raw, const tools::Operation& op,
+                                 const InputOptions& options, std::string&) {
+        FinalFuncReturn rt;
+        const std::string& dir = exportDir(op, options);
+        if (dir.empty()) {
+            rt.success = false;
+            rt.logs = {logs::alog(LOG_TYPE::Error, "未指定导出目录，请使用 -i 输入")};
+            return rt;
+        }
+        const auto doc = decodeDocument(path.string(), raw, options, rt);
+        if (!doc) {
+            return rt;
+        }
+        return CodeExport::session(fs::path(reinterpret_cast<const char8_t*>(dir.c_str())))
+            .add(relativeName(path, options), doc->text());
+    }
+
+    FinalFuncReturn cbExportFinish(const tools::Operation& op, const InputOptions& options, const bool complete) {
+        const std::string& dir = exportDir(op, options);
+        if (dir.empty()) {
+            FinalFuncReturn rt;
+            rt.success = true;
+            return rt;
+        }
+        // 完整扫描了整个文件夹时，清单中本次没有见到的文档已被删除或改名，不再保留
+        std::error_code ec;
+        const bool fullScan = complete && !options.watch && options.changedSince.empty() && !options.staged &&
+                              fs::is_directory(options.path, ec);
+        return CodeExport::finishSession(fs::path(reinterpret_cast<const char8_t*>(dir.c_str())), !fullScan);
+    }
+
+    // fm get <键>：值放入 rt.output，没有这个键时不输出；fm set <键> <值>：值为其余附加参数或 -i；fm del <键>
+    // 在 front matter 上执行 fm 操作，返回新的 front matter，未修改或查询时返回 nullopt
+    std::optional<std::string> fmEdit(const std::string_view header, const tools::Operation& op,
+                                      const InputOptions& options, const std::string& name, FinalFuncReturn& rt) {
+        rt.success = false;
+        const std::string& key = op.args.empty() ? options.input : op.args.front();
+        if (key.empty()) {
+            rt.logs = {logs::alog(LOG_TYPE::Error, "未指定 front matter 的键，请使用附加参数或 -i 输入")};
+            return std::nullopt;
+        }
+        rt.success = true;
+        const std::string prefix = name.empty() ? "" : name + "：";
+
+        if (op.action == "get") {
+            if (const auto field = FrontMatter::find(header, key)) {
+                rt.output = field->text();
+            } else {
+                rt.logs.emplace_back(LOG_TYPE::Info, prefix + "没有 " + key);
+            }
+            return std::nullopt;
+        }
+
+        std::string updated;
+        if (op.action == "set") {
+            // 键由 -i 输入时值只能来自附加参数
+            std::string value = op.args.size() == 1 ? options.input : std::string();
+            for (size_t i = 1; i < op.args.size(); ++i) {
+                value += (i > 1 ? " " : "") + op.args[i];
+            }
+            if (value.empty()) {
+                rt.success = false;
+                rt.logs = {logs::alog(LOG_TYPE::Error, "未指定 " + key + " 的值，请使用附加参数或 -i 输入")};
+                return std::nullopt;
+            }
+            updated = FrontMatter::set(header, key, value);
+        } else {
+            updated = FrontMatter::remove(header, key);
+        }
+        if (updated == header) {
+            rt.logs.emplace_back(LOG_TYPE::Info, "未发生修改：" + name);
+            return std::nullopt;
+        }
+        rt.modified = true;
+        return updated;
+    }
+
+    FinalFuncReturn fmText(const std::string_view text, const tools::Operation& op,
+                           const InputOptions& options, const TextSink& sink) {
+        FinalFuncReturn rt;
+        const std::string_view header = text.substr(0, FrontMatter::locate(text, true));
+        const auto updated = fmEdit(header, op, options, "", rt);
+        if (!rt.success) {
+            return rt;
+        }
+        if (updated) {
+            sink(*updated);
+            sink(text.substr(header.size()));
+        } else {
+            sink(text);
+        }
+        return rt;
+    }
+
+    bool isAscii(const std::string_view s) {
+        return std::all_of(s.begin(), s.end(), [](const char c) {
+            return static_cast<unsigned char>(c) < 0x80;
+        });
+    }
+
+    // 从正文确定文档字符集：先看已读入的部分，其中没有非 ASCII 字节时再抽样读取文件
+    std::optional<std::string> bodyCharset(const fs::path& path, const FrontMatter::Head& head) {
+        encoding& enc = threadEncoding();
+        std::string_view sample = std::string_view(head.data).substr(head.end);
+        if (!head.eof) {
+            // 去除末尾可能被截断的多字节序列
+            size_t keep = sample.size();
+            while (keep > 0 && sample.size() - keep < 3 &&
+                   (static_cast<unsigned char>(sample[keep - 1]) & 0xC0) == 0x80) {
+                --keep;
+            }
+            if (keep > 0 && static_cast<unsigned char>(sample[keep - 1]) >= 0xC0) {
+                --keep;
+            }
+            sample = sample.substr(0, keep);
+        }
+
+        std::optional<std::string> charset;
+        if (!isAscii(sample)) {
+            charset = tool::isUtf8(sample) ? std::optional<std::string>("UTF-8") : enc.detect_charset(sample);
+        } else if (head.eof) {
+            charset = "UTF-8";
+        } else {
+            charset = enc.detect_file_charset(reinterpret_cast<const char*>(path.c_str()));
+        }
+        if (charset && *charset == "ASCII") {
+            charset = "UTF-8";
+        }
+        return charset;
+    }
+
+    // 只读取文档开头的 front matter；修改时只替换这一段，正文不读入也不转换
+    FinalFuncReturn fmFile(const fs::path& path, const tools::Operation& op, const InputOptions& options) {
+        FinalFuncReturn rt;
+        std::string error;
+        const auto head = FrontMatter::read(path, error);
+        if (!head) {
+            rt.success = false;
+            rt.logs = {logs::alog(LOG_TYPE::Error, error)};
+            return rt;
+        }
+
+        // 非 utf8 的 front matter 只解码这一段，修改后按原字符集编码
+        encoding& enc = threadEncoding();
+        const std::string filename = path.string();
+        std::string_view header = head->header();
+        std::string charset = "UTF-8";
+        std::optional<std::string> decoded;
+        if (!tool::isUtf8(header)) {
+            const auto detected = enc.detect_charset(header);
+            if (detected) {
+                charset = *detected;
+                decoded = enc.decodeToUtf8(header, charset);
+            }
+            if (!decoded) {
+                rt.success = false;
+                rt.logs = {logs::alog(LOG_TYPE::Error, "读取 front matter 为utf8遇到错误：" + filename)};
+                return rt;
+            }
+            header = *decoded;
+        }
+
+        auto updated = fmEdit(header, op, options, filename, rt);
+        if (!rt.success || !updated) {
+            return rt;
+        }
+        // 纯 ASCII(或尚不存在)的 front matter 不能说明文档字符集，写入非 ASCII 内容前从正文确定
+        if (!decoded && isAscii(header) && !isAscii(*updated)) {
+            const auto detected = bodyCharset(path, *head);
+            if (!detected) {
+                rt.success = false;
+                rt.logs = {logs::alog(LOG_TYPE::Error, "检测字符集遇到错误，未写入：" + filename)};
+                return rt;
+            }
+            charset = *detected;
+        }
+        if (decoded) {
+            // 解码时换行统一为 \n，写回前还原
+            if (head->header().find("\r\n") != std::string_view::npos) {
+                std::string crlf;
+                crlf.reserve(updated->size() + updated->size() / 16);
+                for (const char c : *updated) {
+                    if (c == '\n') {
+                        crlf += '\r';
+                    }
+                    crlf += c;
+                }
+                updated = std::move(crlf);
+            }
+        }
+        if (charset != "UTF-8") {
+            updated = enc.encodeFromUtf8(*updated, charset);
+            if (!updated) {
+                rt.success = false;
+                rt.logs = {logs::alog(LOG_TYPE::Error, "保存失败：" + filename)};
+                return rt;
+            }
+        }
+        if (!FrontMatter::splice(path, *head, *updated, error)) {
+            rt.success = false;
+            rt.logs = {logs::alog(LOG_TYPE::Error, error)};
+            return rt;
+        }
+        rt.logs.emplace_back(LOG_TYPE::Info, "处理完成：" + filename);
+        return rt;
+    }
+
+    struct OpEntry {
+        const char* target;
+        const char* action;
+        TextFunc func;
+        const StreamProcessor::Splitter* stream;   // 不为空表示不依赖整篇上下文，可以流式处理
+        PartitionFunc partition;                   // 不为空表示可以切分为多个分区并行处理
+        FileFunc file;                             // 不为空时由其处理原始内容，不经过 func
+        FinishFunc finish;                         // 不为空时在所有文档处理完后调用
+        PathFunc path;                             // 不为空时文件由其自行读写，不经过整篇读入
+    };
+
+    // 按 ``` 代码块切分流式处理的窗口
+    constexpr StreamProcessor::Splitter fenceSplitter{CodeBlock::streamCut, CodeBlock::streamSkip};
+
+    const OpEntry opTable[] = {
+        {"cb.li", "add", cbLiAdd, &fenceSplitter, CodeBlock::partition},
+        {"cb.ct", "add", cbCtAdd, &fenceSplitter, CodeBlock::partition},
+        {"cb.ct", "rmv", cbCtDel, &fenceSplitter, CodeBlock::partition},
+        {"cb.ct", "del", cbCtDel, &fenceSplitter, CodeBlock::partition},
+        {"cb.ct", "format", cbCtFormat, &fenceSplitter, CodeBlock::partition},
+        {"tb", "format", tbFormat, nullptr, nullptr},
+        {"en", "utf8", enUtf8, nullptr, nullptr, normalizeEncoding},
+        {"cb", "export", cbExport, nullptr, nullptr, cbExportFile, cbExportFinish},
+        {"fm", "get", fmText, nullptr, nullptr, nullptr, nullptr, fmFile},
+        {"fm", "set", fmText, nullptr, nullptr, nullptr, nullptr, fmFile},
+        {"fm", "del", fmText, nullptr, nullptr, nullptr, nullptr, fmFile},
+    };
+
+    const OpEntry* findOp(const tools::Operation& op) {
+        for (const auto& entry : opTable) {
+            if (op.target == entry.target && op.action == entry.action) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    // 文件级的处理线程与文档内的分区线程共用的名额，合计不超过 jobs
+    ThreadBudget threadBudget;
+
+    // 执行单个操作，大文档按分区并行处理后按顺序拼接
+    // docSize 为整篇文档的大小(流式处理时 text 只是其中一个窗口)，据此决定分区数
+    FinalFuncReturn runOp(const std::string_view text, const OpEntry& entry, const tools::Operation& op,
+                          const InputOptions& options, const TextSink& sink, const size_t docSize) {
+        const size_t jobs = options.jobs > 0 ? static_cast<size_t>(options.jobs)
+                                             : std::max(1u, std::thread::hardware_concurrency());
+        const ThreadBudget::Slot slot(threadBudget);
+        const size_t parts = std::min({jobs, docSize / kMinPartSize, text.size() / kMinWindowPart});
+
+        // 只借用空闲的名额，借不到时不分区，由当前线程处理整篇
+        const size_t borrowed = entry.partition && parts > 1 ? threadBudget.tryAcquire(parts - 1, jobs) : 0;
+        const auto starts = borrowed > 0 ? entry.partition(text, borrowed + 1) : std::vector<size_t>{0};
+        // 分区可能少于请求的数量，多借的名额立即归还
+        const size_t extra = std::min(borrowed, starts.size() - 1);
+        threadBudget.release(borrowed - extra);
+        if (starts.size() < 2) {
+            return entry.func(text, op, options, sink);
+        }
+
+        std::vector<std::string> outputs(starts.size());
+        std::vector<FinalFuncReturn> results(starts.size());
+        const auto runPart = [&](const size_t i) {
+            const size_t end = i + 1 < starts.size() ? starts[i + 1] : text.size();
+            const std::string_view region = text.substr(starts[i], end - starts[i]);
+            outputs[i].reserve(region.size() + 64);
+            results[i] = entry.func(region, op, options, [&outputs, i](const std::string_view part) {
+                outputs[i].append(part);
+            });
+        };
+        // 借到的线程与当前线程一起依次领取分区
+        std::atomic<size_t> next = 0;
+        const auto runParts = [&] {
+            for (size_t i = next++; i < starts.size(); i = next++) {
+                runPart(i);
+            }
+        };
+        std::vector<std::thread> workers;
+        workers.reserve(extra);
+        for (size_t i = 0; i < extra; ++i) {
+            workers.emplace_back(runParts);
+        }
+        runParts();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        threadBudget.release(extra);
+
+        FinalFuncReturn rt;
+        rt.success = true;
+        for (const auto& r : results) {
+            rt.logs.insert(rt.logs.end(), r.logs.begin(), r.logs.end());
+            rt.success &= r.success;
+            rt.modified |= r.modified;
+        }
+        if (rt.success) {
+            for (const auto& out : outputs) {
+                sink(out);
+            }
+        }
+        return rt;
+    }
+}
+
+
+std::optional<tools::Operation> tools::parseOperation(const std::string& option) {
+    std::istringstream in(option);
+    std::vector<std::string> words;
+    std::string word;
+    while (in >> word) {
+        words.push_back(word);
+    }
+    if (words.empty()) {
+        return std::nullopt;
+    }
+
+    // 快捷操作
+    if (words.size() == 1) {
+        if (words[0] == "addl") {
+            return Operation{"cb.li", "add", {}};
+        }
+        if (words[0] == "delc") {
+            return Operation{"cb.ct", "del", {}};
+        }
+        return std::nullopt;
+    }
+
+    Operation op;
+    op.target = words[0];
+    op.action = words[1];
+    op.args.assign(words.begin() + 2, words.end());
+    return op;
+}
+
+FinalFuncReturn tools::transform(const std::string_view text, const InputOptions& options, const TextSink& sink) {
+    FinalFuncReturn rt;
+    const auto op = parseOperation(options.option);
+    if (!op) {
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, "无法解析操作：" + options.option)};
+        return rt;
+    }
+    const OpEntry* entry = findOp(*op);
+    if (!entry) {
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, "暂不支持的操作：" + options.option)};
+        return rt;
+    }
+
+    // start > 0 处理分割后的第二部分，否则处理第一部分；未处理部分原样输出
+    const size_t split_pos = tool::splitPos(text, options.start);
+    const bool second = options.start > 0;
+    const std::string_view head = second ? text.substr(0, split_pos) : std::string_view();
+    const std::string_view content = second ? text.substr(split_pos) : text.substr(0, split_pos);
+    const std::string_view tail = second ? std::string_view() : text.substr(split_pos);
+
+    if (!head.empty()) {
+        sink(head);
+    }
+    rt = runOp(content, *entry, *op, options, sink, content.size());
+    if (rt.success && !tail.empty()) {
+        sink(tail);
+    }
+    return rt;
+}
+
+FinalFuncReturn tools::transform(const std::string_view text, const InputOptions& options, std::string& out) {
+    out.clear();
+    out.reserve(text.size() + 64);
+    return transform(text, options, [&out](const std::string_view part) {
+        out.append(part);
+    });
+}
+
+FinalFuncReturn tools::processFile(const fs::path& path, const InputOptions& options) {
+    FinalFuncReturn rt;
+    encoding& enc = threadEncoding();
+    const auto filename = reinterpret_cast<const char *>(path.c_str());
+
+    const auto op = parseOperation(options.option);
+    const OpEntry* entry = op ? findOp(*op) : nullptr;
+    if (entry && entry->path) {
+        return entry->path(path, *op, options);
+    }
+
+    // 超大文档且操作不依赖整篇上下文时流式处理，避免整篇读入内存
+    std::error_code ec;
+    const auto size = fs::file_size(path, ec);
+    if (!ec && size >= options.kStreamThreshold && entry && entry->stream && options.start == 0) {
+        const auto charset = enc.detect_file_charset(filename);
+        if (!charset) {
+            rt.success = false;
+            rt.logs = {logs::alog(LOG_TYPE::Error, "检测字符集遇到错误：" + path.string())};
+            return rt;
+        }
+        return StreamProcessor::run(path, *charset, *entry->stream,
+            [&](const std::string_view window, const TextSink& sink) {
+                return runOp(window, *entry, *op, options, sink, size);
+            });
+    }
+
+    const auto raw = readRaw(path);
+    if (!raw) {
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, "读取文件失败：" + path.string())};
+        return rt;
+    }
+
+    std::string output;
+    rt = processData(path, *raw, options, output);
+    if (!rt.success || !rt.modified) {
+        return rt;
+    }
+    if (!writeRaw(path, output)) {
+        rt.success = false;
+        rt.logs.emplace_back(LOG_TYPE::Error, "保存失败：" + path.string());
+        return rt;
+    }
+    rt.logs.emplace_back(LOG_TYPE::Info, "处理完成：" + path.string());
+    return rt;
+}
+
+FinalFuncReturn tools::processData(const fs::path& path, const std::string_view raw,
+                                   const InputOptions& options, std::string& output) {
+    // 需要文件路径或原始字节的操作直接处理读入的内容
+    if (const auto op = parseOperation(options.option)) {
+        if (const OpEntry* entry = findOp(*op); entry && entry->file) {
+            return entry->file(path, raw, *op, options, output);
+        }
+    }
+
+    FinalFuncReturn rt;
+    encoding& enc = threadEncoding();
+    const std::string filename = path.string();
+    const auto doc = decodeDocument(filename, raw, options, rt);
+    if (!doc) {
+        return rt;
+    }
+
+    std::string result;
+    rt = transform(doc->text(), options, result);
+    if (!rt.success) {
+        return rt;
+    }
+
+    if (rt.modified) {
+        if (doc->charset == "UTF-8") {
+            output = std::move(result);
+        } else if (auto encoded = enc.encodeFromUtf8(result, doc->charset)) {
+            output = std::move(*encoded);
+        } else {
+            rt.success = false;
+            rt.logs.emplace_back(LOG_TYPE::Error, "保存失败：" + filename);
+            return rt;
+        }
+        // 操作报告了修改但字节完全相同(如格式化已规整的文档)时不写回
+        rt.modified = output != raw;
+    }
+    if (!rt.modified) {
+        output.clear();
+        rt.logs.emplace_back(LOG_TYPE::Info, "未发生修改：" + filename);
+    }
+    return rt;
+}
+
+namespace {
+    // 调用操作的 finish，并把结果合并到 rt
+    FinalFuncReturn finishOp(const InputOptions& options, FinalFuncReturn rt) {
+        const auto op = tools::parseOperation(options.option);
+        const OpEntry* entry = op ? findOp(*op) : nullptr;
+        if (!entry || !entry->finish) {
+            return rt;
+        }
+        auto r = entry->finish(*op, options, rt.success);
+        rt.logs.insert(rt.logs.end(), r.logs.begin(), r.logs.end());
+        rt.success = rt.success && r.success;
+        return rt;
+    }
+
+    // 多个文档的查询结果每行一个：相对路径、制表符、值；其中的 \、制表符与换行转义为 \\ \t \n \r
+    void appendEscaped(std::string& out, const std::string_view s) {
+        for (const char c : s) {
+            switch (c) {
+                case '\\': out += "\\\\"; break;
+                case '\t': out += "\\t"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                default: out += c;
+            }
+        }
+    }
+
+    // 文件来源：把找到的每个文档交给回调，返回统计与日志
+    using FileSource = std::function<DirWalker::Result(const DirWalker::FileCallback& onFile)>;
+
+    // 扫描 -> 批量读取 -> 多线程处理 -> 批量写回，各阶段之间用有界队列衔接
+    // 读写交给 IoBackend，同时保持多个文件的请求，处理线程不再阻塞在磁盘上
+    FinalFuncReturn runBatch(const FileSource& source, const InputOptions& options) {
+        FinalFuncReturn rt;
+        const unsigned jobs = options.jobs > 0 ? static_cast<unsigned>(options.jobs)
+                                               : std::max(1u, std::thread::hardware_concurrency());
+        const auto io = IoBackend::create(options.io, kIoDepth);
+        WorkQueue<fs::path> paths(jobs * 64);
+        WorkQueue<IoFile> loaded(jobs * 4);
+        WorkQueue<IoFile> toWrite(jobs * 4);
+        std::mutex logMutex;
+        std::vector<std::pair<std::string, std::string>> outputs;
+        std::atomic<size_t> modified = 0;
+        std::atomic<size_t> failed = 0;
+
+        // 自行读写文件的操作不经过批量读取，路径直接交给处理线程
+        const auto op = tools::parseOperation(options.option);
+        const OpEntry* entry = op ? findOp(*op) : nullptr;
+        const bool direct = entry && entry->path;
+        std::thread reader([&] {
+            if (direct) {
+                while (auto file = paths.pop()) {
+                    loaded.push(IoFile{.path = std::move(*file), .deferred = true});
+                }
+            } else {
+                io->readFiles(paths, loaded, options.kStreamThreshold);
+            }
+            loaded.close();
+        });
+        std::vector<IoFile> writeFailed;
+        std::thread writer([&] {
+            io->writeFiles(toWrite, writeFailed);
+        });
+
+        std::vector<std::thread> workers;
+        workers.reserve(jobs);
+        for (unsigned i = 0; i < jobs; ++i) {
+            workers.emplace_back([&] {
+                while (auto file = loaded.pop()) {
+                    // 处理期间占用一个名额，等待下一个文档时让给其他线程中的大文档分区
+                    const ThreadBudget::Slot slot(threadBudget);
+                    FinalFuncReturn r;
+                    if (file->deferred) {
+                        // 超大文档或自行读写的操作走逐文件流程
+                        r = tools::processFile(file->path, options);
+                    } else if (file->error) {
+                        r.success = false;
+                        r.logs = {logs::alog(LOG_TYPE::Error, "读取文件失败：" + file->path.string() +
+                                                              "，" + strerror(file->error))};
+                    } else {
+                        std::string output;
+                        r = tools::processData(file->path, file->data, options, output);
+                        if (r.success && r.modified) {
+                            r.logs.emplace_back(LOG_TYPE::Info, "处理完成：" + file->path.string());
+                            toWrite.push(IoFile{std::move(file->path), std::move(output)});
+                        }
+                    }
+                    if (!r.success) {
+                        ++failed;
+                    } else if (r.modified) {
+                        ++modified;
+                    }
+                    std::lock_guard lock(logMutex);
+                    rt.logs.insert(rt.logs.end(), r.logs.begin(), r.logs.end());
+                    if (r.output) {
+                        outputs.emplace_back(relativeName(file->path, options), std::move(*r.output));
+                    }
+                }
+            });
+        }
+
+        auto scan = source([&paths](const fs::path& file) {
+            return paths.push(file);
+        });
+        paths.close();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        toWrite.close();
+        writer.join();
+        reader.join();
+
+        // 写回失败的文档此前已计入修改数，这里改记为失败
+        for (const auto& file : writeFailed) {
+            --modified;
+            ++failed;
+            rt.logs.emplace_back(LOG_TYPE::Error, "保存失败：" + file.path.string() + "，" + strerror(file.error));
+        }
+
+        // 查询结果按路径排序，与处理顺序无关
+        if (!outputs.empty()) {
+            std::sort(outputs.begin(), outputs.end());
+            rt.output.emplace();
+            for (const auto& [name, value] : outputs) {
+                if (!rt.output->empty()) {
+                    *rt.output += '\n';
+                }
+                appendEscaped(*rt.output, name);
+                *rt.output += '\t';
+                appendEscaped(*rt.output, value);
+            }
+        }
+
+        rt.logs.insert(rt.logs.end(), scan.logs.begin(), scan.logs.end());
+        if (!direct) {
+            rt.logs.emplace_back(LOG_TYPE::Info, std::string("读写后端：") + io->name());
+        }
+        rt.logs.emplace_back(LOG_TYPE::MainInfo,
+            "共处理 " + std::to_string(scan.files) + " 个文档，修改 " + std::to_string(modified.load()) +
+            " 个，失败 " + std::to_string(failed.load()) + " 个");
+        // 扫描超时时只处理了部分文档，整次运行视为失败
+        rt.success = failed == 0 && !scan.timedOut;
+        rt.modified = modified > 0;
+        return rt;
+    }
+}
+
+FinalFuncReturn tools::processFolder(const fs::path& path, const InputOptions& options) {
+    if (!parseOperation(options.option)) {
+        FinalFuncReturn rt;
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, "无法解析操作：" + options.option)};
+        return rt;
+    }
+
+    const DirWalker walker(options.kDefaultPathScanTimeout);
+    return runBatch([&](const DirWalker::FileCallback& onFile) {
+        return walker.walk(path, onFile);
+    }, options);
+}
+
+FinalFuncReturn tools::processChanged(const fs::path& path, const InputOptions& options) {
+    FinalFuncReturn rt;
+    if (!parseOperation(options.option)) {
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, "无法解析操作：" + options.option)};
+        return rt;
+    }
+    auto repo = GitRepo::discover(path);
+    if (!repo) {
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, "不在 git 仓库中：" + path.string())};
+        return rt;
+    }
+
+    auto changed = options.staged ? repo->changed("HEAD", false) : repo->changed(options.changedSince, true);
+    if (!changed.success) {
+        rt.success = false;
+        rt.logs = std::move(changed.logs);
+        return rt;
+    }
+
+    // 只处理 path 之下的文档；path 为单个文件时只处理它本身
+    std::error_code ec;
+    const fs::path scope = fs::weakly_canonical(fs::absolute(path, ec), ec);
+    const fs::path root = fs::weakly_canonical(repo->workTree(), ec);
+    return runBatch([&](const DirWalker::FileCallback& onFile) {
+        DirWalker::Result scan;
+        scan.logs = std::move(changed.logs);
+        for (const auto& rel : changed.paths) {
+            const fs::path file = root / fs::path(reinterpret_cast<const char8_t*>(rel.c_str()));
+            const auto [end, _] = std::mismatch(scope.begin(), scope.end(), file.begin(), file.end());
+            if (end != scope.end() || !fs::is_regular_file(file, ec)) {
+                continue;
+            }
+            ++scan.files;
+            ++scan.entries;
+            if (!onFile(file)) {
+                break;
+            }
+        }
+        return scan;
+    }, options);
+}
+
+FinalFuncReturn tools::execute(const InputOptions& options) {
+    FinalFuncReturn rt;
+    const fs::path& path = options.path;
+    if (path.empty()) {
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, "未指定md文档路径，请使用 -p 输入")};
+        return rt;
+    }
+
+    std::error_code ec;
+    if (!options.changedSince.empty() || options.staged) {
+        rt = processChanged(path, options);
+    } else if (fs::is_directory(path, ec)) {
+        rt = processFolder(path, options);
+    } else if (fs::is_regular_file(path, ec)) {
+        rt = processFile(path, options);
+    } else {
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, "文件不存在：" + path.string())};
+        return rt;
+    }
+    return finishOp(options, std::move(rt));
+}
+
+FinalFuncReturn tools::watch(const InputOptions& options) {
+    FinalFuncReturn rt;
+    if (options.path.empty()) {
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, "未指定md文档路径，请使用 -p 输入")};
+        return rt;
+    }
+    if (!parseOperation(options.option)) {
+        rt.success = false;
+        rt.logs = {logs::alog(LOG_TYPE::Error, "无法解析操作：" + options.option)};
+        return rt;
+    }
+
+    // 常驻进程内复用字符集缓存、iconv 转换器与已编译的正则
+    InputOptions watchOptions = options;
+    watchOptions.watch = true;
+    Watcher watcher(options.path, [watchOptions](const fs::path& file) {
+        return finishOp(watchOptions, processFile(file, watchOptions));
+    });
+    return watcher.run();
+}
@@ -5,4 +5,46 @@
 #ifndef MDTOOL2_TOOLS_H
 #define MDTOOL2_TOOLS_H
 
+#include <string_view>
+
+#include "../global.h"
+
+// mdtool_core 对外接口，命令行只是这一层的薄封装
+namespace tools {
+    // 解析后的单个操作，如 "cb.li add"
+    struct Operation {
+        std::string target;              // 操作对象，如 cb.li
+        std::string action;              // 操作内容，如 add
+        std::vector<std::string> args;   // 附加参数
+    };
+
+    // 解析 InputOptions::option 中的操作字符串
+    std::optional<Operation> parseOperation(const std::string& option);
+
+    // 内存接口：对 utf8 文本执行 options.option 指定的操作，结果按顺序交给 sink
+    // 未修改的片段直接引用 text，不进行任何文件读写
+    FinalFuncReturn transform(std::string_view text, const InputOptions& options, const TextSink& sink);
+    FinalFuncReturn transform(std::string_view text, const InputOptions& options, std::string& out);
+
+    // 读取单个文档，处理后按原编码写回
+    FinalFuncReturn processFile(const fs::path& path, const InputOptions& options);
+
+    // 处理已读入内存的原始文档内容，修改后按原编码放入 output，不进行任何文件读写
+    // 结果与原始字节相同时视为未修改
+    FinalFuncReturn processData(const fs::path& path, std::string_view raw,
+                                const InputOptions& options, std::string& output);
+
+    // 扫描文件夹中的 md 文档并交给多个线程并行处理
+    FinalFuncReturn processFolder(const fs::path& path, const InputOptions& options);
+
+    // 只处理 git 仓库中相对 options.changedSince 或已暂存(options.staged)发生变化的 md 文档
+    FinalFuncReturn processChanged(const fs::path& path, const InputOptions& options);
+
+    // 命令行入口：options.path 可以是单个文档或文件夹
+    FinalFuncReturn execute(const InputOptions& options);
+
+    // 常驻监听 options.path，文档保存后立即执行操作
+    FinalFuncReturn watch(const InputOptions& options);
+}
+
 #endif //MDTOOL2_TOOLS_H
\ No newline at end of file